@@ -402,26 +402,49 @@ private:
 	board::piece_type who;
 };
 
-class AlphaGo {
+/**
+ * the policy network of AlphaGo_trainer, which picks the most probable legal move
+ *
+ * weights: the weights file (../AlphaGo_trainer/policy/epoch150_weights.pt by default)
+ * device: cpu, cuda, or auto for CUDA when present and the CPU otherwise (by default)
+ * threads: the intra-op threads of the CPU inference (the torch default if not given)
+ *
+ * the network is warmed up by a forward pass at construction, so the first genmove does not pay the lazy initialization
+ */
+class AlphaGo : public agent {
 public:
 	az::AlphaZeroNetwork network = nullptr;
+	torch::Device device = torch::kCPU;
+
+	AlphaGo(const std::string& args = "") : agent("name=alpha role=unknown " + args) {
+		std::string weights_file = meta.find("weights") != meta.end() ? property("weights") : "../AlphaGo_trainer/policy/epoch150_weights.pt";
+		std::string type = meta.find("device") != meta.end() ? property("device") : "auto";
+		if (type == "cuda") device = torch::kCUDA;
+		else if (type == "auto") device = torch::cuda::is_available() ? torch::kCUDA : torch::kCPU;
+		else if (type != "cpu") throw std::invalid_argument("invalid device: " + type);
+		if (device.is_cuda() && !torch::cuda::is_available()) throw std::invalid_argument("no CUDA device");
+		if (meta.find("threads") != meta.end()) torch::set_num_threads(int(meta["threads"]));
+		if (!std::ifstream(weights_file).good()) throw std::invalid_argument("cannot open weights: " + weights_file);
 
-	AlphaGo() {
 		const auto net_op = az::NetworkOptions{7, 9, 9, 128, 2, 81};
 		az::AlphaZeroNetwork net(net_op);
 		network = net;
-		std::string weights_file = "../AlphaGo_trainer/policy/epoch150_weights.pt";
-		torch::load(network, weights_file);
-		network->to(torch::kCUDA);
+		torch::load(network, weights_file, device);
+		network->to(device);
 		network->eval();
+
+		torch::NoGradGuard no_grad;
+		board empty;
+		network->forward(getTensor(empty, empty, empty).to(device));
 	}
 
 	int get_policy_move(MovingStates &moving_states) {
 		board seq1 = moving_states.states[0];
 		board seq2 = moving_states.states[1];
 		board seq3 = moving_states.states[2];
+		torch::NoGradGuard no_grad;
 		auto data = getTensor(seq1, seq2, seq3);
-		data = data.to(torch::kCUDA);
+		data = data.to(device);
 		auto [v_out, p_out] = network->forward(data);
 		p_out = torch::softmax(p_out, 1);
 		std::unordered_map<int, float> action_probs;
@@ -24,7 +24,7 @@ int main(int argc, const char* argv[]) {
 	std::cout << std::endl << std::endl;
 
 	size_t total = 1000, block = 0, limit = 0;
-	std::string black_args, white_args;
+	std::string black_args, white_args, alpha_args;
 	std::string load_path, save_path;
 	std::string name = "TCG-HollowNoGo-Demo", version = "2022"; // for GTP shell
 	bool shell = false;
@@ -48,6 +48,8 @@ int main(int argc, const char* argv[]) {
 			black_args = next_opt();
 		} else if (match_arg("white")) {
 			white_args = next_opt();
+		} else if (match_arg("alpha")) {
+			alpha_args = next_opt();
 		} else if (match_arg("load")) {
 			load_path = next_opt();
 		} else if (match_arg("save")) {
@@ -97,7 +99,7 @@ int main(int argc, const char* argv[]) {
 	} else { // launch GTP shell
 		int steps = 0;
 		MovingStates moving_states;
-		AlphaGo alpha_mover;
+		AlphaGo alpha_mover(alpha_args);
 
 		for (std::string command; std::getline(std::cin, command); ) {
 			if (command.back() == '\r') command.pop_back();
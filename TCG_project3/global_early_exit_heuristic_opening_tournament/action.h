@@ -71,6 +71,12 @@ public:
 	board::piece_type color() const { return static_cast<board::piece_type>(event() >> 16); }
 public:
 	board::reward apply(board& b) const { return b.place(position(), color()); }
+	/**
+	 * the regular expression of a move in this format, e.g., ;B[aa] to ;W[ii] on 9x9
+	 */
+	static std::string syntax() {
+		return std::string(";[BW]\\[[a-") + char('a' + board::size_x - 1) + "][a-" + char('a' + board::size_y - 1) + "]\\]";
+	}
 	std::ostream& operator >>(std::ostream& out) const {
 		return out << ';' << "?BW?"[color() & 0b11] << '[' << char('a' + position().x)
 		           << char('a' + ((board::size_y - 1) - position().y)) << ']';
@@ -0,0 +1,65 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * affinity.h: CPU sets and thread pinning for the search threads
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <stdexcept>
+#include <sched.h>
+#include <pthread.h>
+
+/**
+ * the CPUs of the search threads, e.g., "0-7,16-23", or the CPUs the process may run on if the list is empty
+ */
+inline std::vector<int> cpu_set_of(const std::string& list = "") {
+	std::vector<int> cpus;
+	if (list.empty()) {
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+			for (int c = 0; c < CPU_SETSIZE; c++) if (CPU_ISSET(c, &allowed)) cpus.push_back(c);
+		}
+		return cpus;
+	}
+	std::stringstream ss(list);
+	for (std::string range; std::getline(ss, range, ','); ) {
+		size_t dash = range.find('-');
+		int first = std::stoi(range.substr(0, dash));
+		int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+		if (first < 0 || last < first || last >= CPU_SETSIZE) throw std::invalid_argument("invalid cpu list: " + list);
+		for (int c = first; c <= last; c++) cpus.push_back(c);
+	}
+	return cpus;
+}
+
+/**
+ * pin the calling thread to one CPU, false if the CPU is not available
+ */
+inline bool pin_thread(int cpu) {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/**
+ * the NUMA node of a CPU from sysfs, or 0 if it is unknown (e.g., a single-node host)
+ */
+inline int numa_node_of(int cpu) {
+	for (int node = 0; node < 64; node++) {
+		std::ifstream dir("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+		if (!dir.is_open()) break;
+		std::string list;
+		dir >> list;
+		for (int c : cpu_set_of(list)) if (c == cpu) return node;
+	}
+	return 0;
+}
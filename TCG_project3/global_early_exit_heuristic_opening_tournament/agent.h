@@ -13,10 +13,23 @@
 #include <sstream>
 #include <map>
 #include <type_traits>
+#include <functional>
 #include <algorithm>
 #include <fstream>
+#include <iomanip>
+#include <chrono>
 #include "board.h"
 #include "action.h"
+#include "position.h"
+#include "pattern.h"
+#include "playout.h"
+#include "dfpn.h"
+#include "endgame.h"
+#include "stopping.h"
+#include "arena.h"
+#include "affinity.h"
+#include "trace.h"
+#include "pool.h"
 
 #include <bits/stdc++.h>
 #include <omp.h>
@@ -48,6 +61,15 @@ public:
 	virtual std::string role() const { return property("role"); }
 
 protected:
+	/**
+	 * read an optional argument, fall back to the default if it is not specified
+	 */
+	template<typename type>
+	type option(const std::string& k, type def) const {
+		auto it = meta.find(k);
+		return it != meta.end() ? type(it->second) : def;
+	}
+
 	typedef std::string key;
 	struct value {
 		std::string value;
@@ -70,11 +92,109 @@ public:
 			engine.seed((unsigned)time(NULL));
 	}
 	virtual ~random_agent() {}
+	virtual void notify(const std::string& msg) {
+		agent::notify(msg);
+		if (msg.find("seed=") == 0) engine.seed(int(meta["seed"])); // reseed, e.g., for each game of a tournament table
+	}
 
 protected:
 	std::default_random_engine engine;
 };
 
+/**
+ * hand-made evaluation of a position and its moves
+ *
+ * all terms are read from a position, which keeps the legal moves and the 3x3 pattern codes up to date,
+ * the local terms of a point are one lookup of pattern::of, and the opponent mobility is a bitset count,
+ * so scoring a move costs a copy of the position and an incremental placement
+ */
+class heuristic {
+public:
+
+	inline static int value(const position& b, board::piece_type who) noexcept {
+		constexpr int EYE_SCORE = 16;
+		constexpr int LIBERTY_SCORE = 1;
+		constexpr int ATARI_SCORE = 8;
+		constexpr int SELF_CORNER_ADJACENT_SCORE = 4;
+		int score = 0;
+		for (int i = 0; i < position::cells; i++) {
+			pattern::feature f = pattern::of(b.pattern(i), who);
+			score +=
+				+ EYE_SCORE                  * (b.at(i) == board::empty && f.eye())
+				+ LIBERTY_SCORE              * f.liberty()
+				+ ATARI_SCORE                * f.atari()
+				+ SELF_CORNER_ADJACENT_SCORE * f.corner();
+		}
+		return score;
+	}
+
+	inline static int action_value(const position& b, int i, board::piece_type who) noexcept {
+		constexpr int EYE_SCORE = 16;
+		constexpr int LIBERTY_SCORE = 8;
+		constexpr int ATARI_SCORE = 24;
+		constexpr int SELF_CORNER_ADJACENT_SCORE = 8;
+		constexpr int OPPO_CORNER_ADJACENT_SCORE = 1;
+		constexpr int OPPO_SIDE_ADJACENT_SCORE = 1;
+		constexpr int BLOCK_OPPO_SCORE = 24;
+		//constexpr int SELF_CAN_PLAY_SCORE = 32;
+		board::piece_type opp = board::piece_type(3u - who);
+		pattern::feature self = pattern::of(b.pattern(i), who), oppo = pattern::of(b.pattern(i), opp);
+		int score =
+			- EYE_SCORE                  * (b.at(i) == board::empty && self.eye())
+			+ LIBERTY_SCORE              * self.liberty()
+			+ ATARI_SCORE                * self.atari()
+			+ SELF_CORNER_ADJACENT_SCORE * self.corner()
+			+ OPPO_CORNER_ADJACENT_SCORE * oppo.corner()
+			+ OPPO_SIDE_ADJACENT_SCORE   * oppo.side();
+
+		int before_count_available_place = count_available_place(b, opp);
+		//int before_count_only_one_can_place = count_only_one_can_place(b, who);
+		position after = b;
+		after.place(i, who);
+		int after_count_available_place = count_available_place(after, opp);
+		//int after_count_only_one_can_place = count_only_one_can_place(after, who);
+
+		score += EYE_SCORE * (
+			+ is_eye(after, position::near(i, 0), who)
+			+ is_eye(after, position::near(i, 1), who)
+			+ is_eye(after, position::near(i, 2), who)
+			+ is_eye(after, position::near(i, 3), who)
+		);
+		score += BLOCK_OPPO_SCORE    * (before_count_available_place - after_count_available_place);
+		//score += SELF_CAN_PLAY_SCORE * (after_count_only_one_can_place - before_count_only_one_can_place);
+		return score;
+	}
+
+	inline static bool is_eye(const position& b, int i, board::piece_type who) noexcept {
+		return b.at(i) == board::empty && pattern::of(b.pattern(i), who).eye();
+	}
+
+	inline static int count_liberty(const position& b, int i) noexcept {
+		return pattern::of(b.pattern(i), board::black).liberty();
+	}
+
+	inline static bool is_atari(const position& b, int i, board::piece_type who) noexcept {
+		return pattern::of(b.pattern(i), who).atari();
+	}
+
+	inline static int count_corner_adjacent(const position& b, int i, board::piece_type who) noexcept {
+		return pattern::of(b.pattern(i), who).corner();
+	}
+
+	inline static int count_side_adjacent(const position& b, int i, board::piece_type who) noexcept {
+		return pattern::of(b.pattern(i), who).side();
+	}
+
+	inline static int count_only_one_can_place(const position& b, board::piece_type who) noexcept {
+		return (b.legal_of(who) & ~b.legal_of(3u - who)).count();
+	}
+
+	inline static int count_available_place(const position& b, board::piece_type who) noexcept {
+		return b.count_legal(who);
+	}
+
+};
+
 /**
  * random player for both side
  * put a legal piece randomly
@@ -91,87 +211,266 @@ public:
 			throw std::invalid_argument("invalid role: " + role());
 		for (size_t i = 0; i < space.size(); i++)
 			space[i] = action::place(i, who);
+		if (option("playout", std::string("random")) == "pattern") {
+			policy = std::make_shared<playout_policy>();
+			if (meta.find("playout_weights") != meta.end())
+				policy->load(property("playout_weights"));
+		}
+		if (meta.find("edb") != meta.end()) {
+			endgame = std::make_shared<endgame_db>();
+			if (!endgame->open(property("edb")))
+				throw std::invalid_argument("cannot open endgame database: " + property("edb"));
+		}
+		if (option("pool", 0)) {
+			pool = &search_pool::shared();
+		}
+		if (meta.find("trace") != meta.end()) {
+			trace = search_trace::shared(property("trace"));
+		}
+	}
+
+	virtual void open_episode(const std::string& flag = "") {
+		games = option("game", games + 1); // the tournament tables number the games by notify("game=...")
+	}
+	virtual void close_episode(const std::string& flag = "") {
+		if (trace) trace->flush();
 	}
 
 	virtual action take_action(const board& state, int steps) {
+		report = search_report();
+		auto start = std::chrono::steady_clock::now();
+		action move = search_action(state, steps);
+		report.msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (option("log_stats", 0)) {
+			std::cerr << name() << " " << move << ": " << search_stats() << std::endl;
+		}
+		if (trace && report.source.size()) {
+			trace_search(state, move);
+		}
+		return move;
+	}
+
+	/**
+	 * what one thread did in a search, collected by node::MCTS
+	 */
+	struct search_counters {
+		uint64_t simulations = 0;
+		uint64_t nodes = 0;     // the nodes expanded
+		uint64_t depth_sum = 0; // the depth of the simulated nodes, summed over the simulations
+		int depth_max = 0;
+		uint32_t depths[64] = {}; // the simulations of each depth, the last one for the deeper ones
+		double select = 0, expand = 0, simulate = 0, backprop = 0; // seconds in each phase
+	};
+
+	/**
+	 * the counters of the last search, see search_stats
+	 */
+	struct search_report {
+		std::string source;   // "mcts", "halving", "dfpn", or empty if nothing was searched
+		double msec = 0;
+		uint64_t budget = 0;  // the simulations allowed for all threads
+		stopping_rule::reason_type stop = stopping_rule::none; // the stopping rule which ended the search early, if any
+		uint64_t stop_at = 0; // the simulations of all threads when the search stopped early
+		uint64_t solved = 0;  // the nodes searched by df-pn, if the move is proven by it
+		std::vector<search_counters> threads;
+		std::vector<search_trace::child> root; // the root children merged over the trees
+		std::vector<uint8_t> pv;
+	};
+	const search_report& last_search() const { return report; }
+
+	/**
+	 * one line of the counters of the last search, e.g.,
+	 *   mcts 48000 sims in 812 ms (59113/s), 4 threads, imbalance 3.1%, 47990 nodes, depth 6.2 avg 14 max,
+	 *   select 12% expand 3% simulate 80% backprop 5%, stop visit at 41%, memory 30.1 MB peak 30.1 MB
+	 * or for a move proven by df-pn, e.g.,
+	 *   dfpn 182311 nodes in 95 ms (1919063/s), memory 30.1 MB peak 30.1 MB
+	 * with pin=1, followed by the threads on each NUMA node, e.g., pinned node 0 x2 node 1 x2
+	 */
+	std::string search_stats() const {
+		std::stringstream ss;
+		ss << std::fixed << std::setprecision(1);
+		if (report.source.empty()) {
+			ss << "no search";
+			return ss.str();
+		}
+		if (report.source == "dfpn") {
+			ss << report.source << " " << report.solved << " nodes in " << report.msec << " ms ("
+			   << uint64_t(report.solved * 1000.0 / std::max(report.msec, 1e-3)) << "/s), "
+			   << "memory " << usage.bytes / 1048576.0 << " MB peak " << usage.peak / 1048576.0 << " MB";
+			return ss.str();
+		}
+		search_counters sum;
+		uint64_t most = 0, least = report.threads.size() ? UINT64_MAX : 0;
+		for (auto &t : report.threads) {
+			sum.simulations += t.simulations;
+			sum.nodes += t.nodes;
+			sum.depth_sum += t.depth_sum;
+			sum.depth_max = std::max(sum.depth_max, t.depth_max);
+			sum.select += t.select;
+			sum.expand += t.expand;
+			sum.simulate += t.simulate;
+			sum.backprop += t.backprop;
+			most = std::max(most, t.simulations);
+			least = std::min(least, t.simulations);
+		}
+		double phases = std::max(sum.select + sum.expand + sum.simulate + sum.backprop, 1e-9);
+		double mean = report.threads.size() ? double(sum.simulations) / report.threads.size() : 0;
+		ss << report.source << " " << sum.simulations << " sims in " << report.msec << " ms ("
+		   << uint64_t(sum.simulations * 1000.0 / std::max(report.msec, 1e-3)) << "/s), "
+		   << report.threads.size() << " threads, imbalance " << (mean ? 100 * (most - least) / mean : 0) << "%, "
+		   << sum.nodes << " nodes, depth " << (sum.simulations ? double(sum.depth_sum) / sum.simulations : 0)
+		   << " avg " << sum.depth_max << " max, "
+		   << "select " << 100 * sum.select / phases << "% expand " << 100 * sum.expand / phases
+		   << "% simulate " << 100 * sum.simulate / phases << "% backprop " << 100 * sum.backprop / phases << "%, ";
+		if (report.stop != stopping_rule::none) {
+			ss << "stop " << stopping_rule::name_of(report.stop) << " at " << (report.budget ? 100.0 * report.stop_at / report.budget : 0) << "%, ";
+		} else {
+			ss << "full budget, ";
+		}
+		ss << "memory " << usage.bytes / 1048576.0 << " MB peak " << usage.peak / 1048576.0 << " MB";
+		if (option("pin", 0) && !pool && numa.size()) { // the threads pinned on each NUMA node, thread i on the i-th CPU
+			std::map<int, int> pinned;
+			for (size_t id = 0; id < report.threads.size(); id++) pinned[numa[id % numa.size()]]++;
+			ss << ", pinned";
+			for (auto &n : pinned) ss << " node " << n.first << " x" << n.second;
+		}
+		return ss.str();
+	}
+
+	/**
+	 * write the last search to the trace
+	 */
+	void trace_search(const board& state, const action& move) {
+		search_trace::record r{}; // the reserved fields are zero
+		r.game = games;
+		r.step = 0; // the stones on the board, since steps is not counted in the local games
+		for (int i = 0; i < board::size_x * board::size_y; i++) {
+			unsigned stone = state[i / board::size_y][i % board::size_y];
+			r.step += stone == board::black || stone == board::white;
+		}
+		r.who = state.info().who_take_turns;
+		r.stop = report.stop;
+		r.source = report.source == "halving" ? search_trace::from_halving
+		         : report.source == "dfpn" ? search_trace::from_dfpn : search_trace::from_mcts;
+		r.threads = std::min<size_t>(report.threads.size(), UINT16_MAX);
+		r.move = move.type() == action::place::type ? action::place(move).position().i : 255;
+		r.msec = report.msec;
+		r.simulations = r.nodes = 0;
+		r.budget = report.budget;
+		r.bytes = usage.bytes;
+		for (auto& p : r.phase) p = 0;
+		std::vector<uint32_t> depths(64, 0);
+		for (auto &t : report.threads) {
+			r.simulations += t.simulations;
+			r.nodes += t.nodes;
+			r.phase[0] += t.select;
+			r.phase[1] += t.expand;
+			r.phase[2] += t.simulate;
+			r.phase[3] += t.backprop;
+			for (int d = 0; d < 64; d++) depths[d] += t.depths[d];
+		}
+		while (depths.size() && depths.back() == 0) depths.pop_back();
+		r.root = report.root;
+		r.moves = report.pv;
+		r.depth = depths;
+		trace->write(r);
+	}
+
+	action search_action(const board& state, int steps) {
 		int N = meta["N"];
-		float c = meta["c"];
+		config c = search_config();
+
+		// solve the endgame exactly once few legal moves remain for both sides
+		int dfpn_threshold = option("dfpn", 0);
+		if (dfpn_threshold) {
+			position pos(state);
+			if (pos.count_legal(board::black) + pos.count_legal(board::white) < dfpn_threshold) {
+				if (!solver) solver = std::make_shared<dfpn_solver>(size_t(option("dfpn_tt", 1 << 20)));
+				int move;
+				dfpn_solver::result res = solver->solve(state, move, option("dfpn_nodes", 1000000), option("dfpn_time", 1000));
+				if (res == dfpn_solver::win && move >= 0) { // otherwise unsolved, fall back to the search
+					report.source = "dfpn";
+					report.solved = solver->searched();
+					record_usage();
+					return action::place(move, state.info().who_take_turns);
+				}
+			}
+		}
+
 		if (N) {
+			if (option("root", std::string("ucb")) == "halving") {
+				return sequential_halving(state, N, c);
+			}
+
 			#ifdef ParallelAverageSelection
-			int thread_num = omp_get_num_procs();
+			int thread_num = search_threads();
 			omp_set_num_threads(thread_num);
 
-			std::vector<std::vector<int>> average_selection(thread_num, std::vector<int>(81, 0));
-			std::vector<node*> root_vec;
-
+			std::vector<node*> root_vec(thread_num);
+			std::vector<std::default_random_engine> engines;
+			prepare_arenas(thread_num);
 			for (int i = 0; i < thread_num; ++i) {
-				node* root = new node(state);
-				root_vec.push_back(root);
-			}
-
-			int split = N / 1000;
-
-			#pragma omp parallel
-			{
-				int id = omp_get_thread_num();
-				root_vec[id]->MCTS(N / 4, engine, c);
-				/*
-				for (auto &all_child : root_vec[id]->child) {
-					average_selection[id][all_child.first] = (all_child.second)->total_cnt;
-				}
-				*/
+				engines.emplace_back(engine());
 			}
-			
-			for (int i = split / 4 + 1; i <= split; ++i) {
 
+			// the threads search until the budget runs out, or until the shared stopping rule holds
+			// each tree is created by its own thread, so it stays on the memory of that thread
+			stopping_rule rule(stopping_options(), uint64_t(N) * thread_num);
+			report.source = "mcts";
+			report.budget = uint64_t(N) * thread_num;
+			report.threads.assign(thread_num, search_counters());
+			if (pool) { // the trees take turns with the searches of the other sessions, a chunk of simulations at a time
+				int chunk = option("pool_chunk", 256);
+				std::vector<int> left(thread_num, N);
+				pool->run(thread_num, [&](int id) {
+					if (!root_vec[id]) root_vec[id] = arenas[id]->create(arenas[id].get(), state);
+					int n = std::min(left[id], chunk);
+					left[id] -= n;
+					root_vec[id]->MCTS(n, engines[id], c, &rule, &report.threads[id]);
+					return left[id] == 0 || rule.stopped();
+				});
+			} else {
 				#pragma omp parallel
 				{
 					int id = omp_get_thread_num();
-					root_vec[id]->MCTS(N / split, engine, c);
-
-					for (auto &all_child : root_vec[id]->child) {
-						average_selection[id][all_child.first] = (all_child.second)->total_cnt;
-					}
-					
+					bind_thread(id);
+					root_vec[id] = arenas[id]->create(arenas[id].get(), state);
+					root_vec[id]->MCTS(N, engines[id], c, &rule, &report.threads[id]);
 				}
+			}
+			report.stop = rule.reason();
+			report.stop_at = rule.stopped_at();
+			record_usage();
+			record_trees(root_vec);
 
-				// early exit
-				std::vector<int> result(81, 0);
-				for (int j = 0; j < 81; ++j) {
-					for (int i = 0; i < thread_num; ++i) {
-						result[j] += average_selection[i][j];
-					}
+			std::vector<int> result(board::size_x * board::size_y, 0);
+			for (auto &root : root_vec) {
+				for (auto &all_child : root->child) {
+					result[all_child.first] += all_child.second->total_cnt;
 				}
+			}
 
-				int max1 = -std::numeric_limits<int>::max();
-				int max2 = -std::numeric_limits<int>::max();
-				for (auto &r : result) {
-					int tmp = r;
-					if (tmp > max1) {
-						max2 = max1;
-						max1 = tmp;
-					} else if (tmp > max2) {
-						max2 = tmp;
-					}
+			if (c.solver) {
+				node* proven = proven_root(root_vec);
+				if (proven != nullptr && proven->proven < 0) { // play the proven win at once
+					int win = proven->proven_win_move();
+					delete_trees(root_vec);
+					return action::place(win, state.info().who_take_turns);
 				}
-
-				float f = 0.5;
-				if (max2 + f * (N * thread_num - ((i * N / split) * thread_num)) < max1) {
-					break;
+				// avoid the moves proven to lose in any tree, unless all moves lose
+				if (proven == nullptr) {
+					for (auto &root : root_vec) {
+						for (auto &all_child : root->child) {
+							if (all_child.second->proven < 0) {
+								result[all_child.first] = 0;
+							}
+						}
+					}
 				}
 			}
 
-			for (auto &root : root_vec) {
-				delete_tree(root);
-			}
+			delete_trees(root_vec);
 
-			std::vector<int> result(81, 0);
-			for (int j = 0; j < 81; ++j) {
-				for (int i = 0; i < thread_num; ++i) {
-					result[j] += average_selection[i][j];
-				}
-			}
-			
 			auto iter = max_element(result.begin(), result.end());
 			if((*iter) == 0){
 				return action();
@@ -193,13 +492,14 @@ public:
 			#pragma omp parallel
 			{
 				int id = omp_get_thread_num();
-				node* root = new node(state);
+				arena<node> memory;
+				node* root = memory.create(&memory, state);
 				int vote_move = root->MCTS(N, engine, c);
 				delete_tree(root);
 				majority_vote[id] = vote_move;
 			}
 
-			std::vector<int> vote_result(81, 0);
+			std::vector<int> vote_result(board::size_x * board::size_y, 0);
 			for(auto &v : majority_vote){
 				if(v != -1){
 					//debug << v << " ";
@@ -222,8 +522,10 @@ public:
 
 			#ifdef Normal
 
-			node* root = new node(state);
+			arena<node> memory;
+			node* root = memory.create(&memory, state);
 			int result = root->MCTS(N, engine, c);
+			delete_tree(root);
 			return action::place(result, state.info().who_take_turns);
 
 			#endif
@@ -241,16 +543,95 @@ public:
 		return action();
 	}
 
+	/**
+	 * how the heuristic priors take part in the tree policy
+	 * none:  uniform priors, expand moves in random order
+	 * bias:  progressive bias, ucb + w * prior / (1 + visit)
+	 * puct:  win rate + w * prior * sqrt(parent visit) / (1 + visit)
+	 */
+	enum prior_mode { prior_none = 0, prior_bias = 1, prior_puct = 2 };
+
+	/**
+	 * search parameters shared by all nodes of a tree
+	 */
+	struct config {
+		float ucb_c;
+		prior_mode prior;
+		float prior_w;    // weight of the prior term
+		float prior_temp; // softmax temperature over heuristic::action_value
+		const playout_policy* playout; // pattern-weighted playouts, or uniformly random if null
+		bool solver;      // prove wins and losses through the tree (MCTS-Solver)
+		const endgame_db* endgame; // end the playouts by the endgame database, or play to the end if null
+		int endgame_at;   // consult the database once both sides have at most this many legal moves in total
+		float endgame_scale; // the logistic scale from the difference of the solo moves to the win probability, with shared regions
+		bool recycle;     // collapse the least visited subtrees once the memory budget is used up, or stop expanding
+		int cutoff;       // end the playouts after this many moves and score them statically, 0 to play to the end
+		int cutoff_margin; // or once the legal moves of one side exceed the other's by this margin, 0 to disable
+		bool cutoff_heuristic; // score by heuristic::value, or by the difference of the legal moves
+		float cutoff_scale; // the logistic scale from the score difference to the win probability
+		int compact;      // move the upper tree into a contiguous block after this many simulations, and again after 4x as many, 0 to disable
+		int compact_nodes; // the most nodes moved by a compaction
+		int compact_min;  // the visits of a node to be moved
+	};
+
+	/**
+	 * the stopping rule of the search, see stopping_rule
+	 */
+	stopping_rule::options stopping_options() const {
+		stopping_rule::options opt;
+		opt.visit = option("stop_visit", opt.visit);
+		opt.ci = option("stop_ci", opt.ci);
+		opt.ci_min = option("stop_ci_min", opt.ci_min);
+		opt.stable = option("stop_stable", opt.stable);
+		opt.min = option("stop_min", opt.min);
+		opt.check = std::max(1, option("stop_check", opt.check));
+		return opt;
+	}
+
+	config search_config() const {
+		config cfg;
+		cfg.ucb_c = option("c", 0.5f);
+		std::string mode = option("prior", std::string("none"));
+		cfg.prior = mode == "bias" ? prior_bias : mode == "puct" ? prior_puct : prior_none;
+		cfg.prior_w = option("prior_w", 1.0f);
+		cfg.prior_temp = option("prior_temp", 16.0f);
+		cfg.playout = policy.get();
+		cfg.solver = option("solver", 0);
+		cfg.endgame = endgame.get();
+		cfg.endgame_at = option("edb_at", 16);
+		cfg.endgame_scale = option("edb_scale", 1.0f);
+		cfg.recycle = option("mem_policy", std::string("recycle")) == "recycle";
+		cfg.cutoff = option("cutoff", 0);
+		cfg.cutoff_margin = option("cutoff_margin", 0);
+		cfg.cutoff_heuristic = option("cutoff_eval", std::string("mobility")) == "heuristic";
+		cfg.cutoff_scale = option("cutoff_scale", cfg.cutoff_heuristic ? 64.0f : 4.0f);
+		cfg.compact = option("compact", 0);
+		cfg.compact_nodes = option("compact_nodes", 4096);
+		cfg.compact_min = option("compact_min", 16);
+		return cfg;
+	}
+
 	class node : board {
 	public:
-		int win_cnt;
+		float win_cnt; // wins - losses, where a cutoff playout counts by its win probability
 		int total_cnt;
 		int place_pos;
-		//std::vector<node*> child;
-		std::unordered_map<int, node*> child;
+		float prior;
+		// the expanded children in the order of moves, as (move, child)
+		std::vector<std::pair<int, node*>> child;
 		node* parent;
-
-		node(const board& state, int m = -1): board(state), place_pos(m), win_cnt(0), total_cnt(0), parent(nullptr) {}
+		// the arena of the tree, which the children are allocated from
+		arena<node>* memory;
+		// legal moves of this state in expansion order, with their priors; filled on the first visit
+		std::vector<int> moves;
+		std::vector<float> move_prior;
+		bool prepared;
+		// the proven result for the player who moved into this node, as win_cnt counts
+		// +1: a proven win, i.e., the player to move here loses; -1: a proven loss; 0: unknown
+		int proven;
+
+		node(arena<node>* memory, const board& state, int m = -1, float p = 1.0):
+			board(state), win_cnt(0), total_cnt(0), place_pos(m), prior(p), parent(nullptr), memory(memory), prepared(false), proven(0) {}
 
 		float win_rate(){
 			if(total_cnt == 0){
@@ -268,53 +649,276 @@ public:
 			return win_rate() + c * std::sqrt(std::log(parent->total_cnt) / total_cnt);
 		}
 
-		int MCTS(int N, std::default_random_engine& engine, float ucb_c){
-			// 1. select  2. expand  3. simulate  4. back propagate
+		float score(const config& cfg){
+			switch(cfg.prior){
+			case prior_bias:
+				return ucb(cfg.ucb_c) + cfg.prior_w * prior / (1 + total_cnt);
+			case prior_puct:
+				return win_rate() + cfg.prior_w * prior * std::sqrt((float)parent->total_cnt) / (1 + total_cnt);
+			default:
+				return ucb(cfg.ucb_c);
+			}
+		}
 
-			// debug
-			//std::fstream debug("record.txt", std::ios::app);
-			
+		/**
+		 * collect the legal moves once, and order them by heuristic priors if enabled
+		 */
+		void prepare(std::default_random_engine& engine, const config& cfg){
+			if(prepared){
+				return ;
+			}
+			prepared = true;
+
+			// the moves symmetric to another move lead to the same game, so only one of them is kept
+			position b(*this);
+			position::mask legal = b.unique_legal_of(info().who_take_turns);
+			for(int i = 0; i < board::size_x * board::size_y; ++i){
+				if(legal[i]){
+					moves.push_back(i);
+				}
+			}
+			std::shuffle(moves.begin(), moves.end(), engine);
+			move_prior.assign(moves.size(), moves.size() ? 1.0f / moves.size() : 0.0f);
+			child.reserve(moves.size());
+			memory->charge(footprint());
+			if(cfg.prior == prior_none || moves.empty()){
+				return ;
+			}
+
+			board::piece_type who = info().who_take_turns;
+			std::vector<float> score(moves.size());
+			for(size_t k = 0; k < moves.size(); ++k){
+				score[k] = heuristic::action_value(b, moves[k], who);
+			}
+			float max_score = *std::max_element(score.begin(), score.end());
+			float sum = 0;
+			for(size_t k = 0; k < moves.size(); ++k){
+				score[k] = std::exp((score[k] - max_score) / cfg.prior_temp);
+				sum += score[k];
+			}
+
+			// expand the most promising moves first, ties stay in shuffled order
+			std::vector<size_t> order(moves.size());
+			for(size_t k = 0; k < order.size(); ++k){
+				order[k] = k;
+			}
+			std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){ return score[a] > score[b]; });
+			std::vector<int> sorted(moves.size());
+			for(size_t k = 0; k < order.size(); ++k){
+				sorted[k] = moves[order[k]];
+				move_prior[k] = score[order[k]] / sum;
+			}
+			moves.swap(sorted);
+		}
+
+		int MCTS(int N, std::default_random_engine& engine, const config& cfg, stopping_rule* rule = nullptr,
+			search_counters* counters = nullptr){
+			// 1. select  2. expand  3. simulate  4. back propagate
+			uint64_t local = 0;
 			for(int i = 0; i < N; ++i){
-				// early exit
-				/*
-				if ((i + 1) % 1000 == 0) {
-					int max1 = -std::numeric_limits<int>::max();
-					int max2 = -std::numeric_limits<int>::max();
-					for (auto &m_child : child) {
-						int tmp = m_child.second->total_cnt;
-						if (tmp > max1) {
-							max2 = max1;
-							max1 = tmp;
-						} else if (tmp > max2) {
-							max2 = tmp;
-						}
+				if(cfg.solver && proven != 0){
+					if(rule){
+						rule->finish();
 					}
+					break; // the result is known, no more simulations are needed
+				}
+				if(rule && rule->stopped()){
+					break;
+				}
+				simulate_from(this, engine, cfg, rule, counters, local);
+			}
+			return select_action();
+		}
 
-					if (max2 + (N - i) < max1) {
-						break;
-					}
+		/**
+		 * one simulation of this tree, where the selection starts from start (this node, or a child chosen by the root policy)
+		 */
+		void simulate_from(node* start, std::default_random_engine& engine, const config& cfg, stopping_rule* rule,
+			search_counters* counters, uint64_t& local){
+			typedef std::chrono::steady_clock clock;
+			auto tick = [&]() { return counters ? clock::now() : clock::time_point(); };
+			auto t0 = tick();
+			// select
+			std::vector<node*> path = start->select_root_to_leaf(engine, cfg);
+			if(start != this){
+				path.insert(path.begin(), this);
+			}
+			auto t1 = tick();
+			// expand
+			node* leaf = path.back();
+			node* expand_node = leaf->expand_from_leaf();
+			if(expand_node != leaf){
+				path.push_back(expand_node);
+			}
+			auto t2 = tick();
+			// simulate
+			float black = path.back()->simulate(engine, cfg);
+			auto t3 = tick();
+			// backpropagate
+			back_propagate(path, black);
+			if(cfg.solver){
+				back_propagate_proof(path);
+			}
+			if(rule && path.size() > 1){ // a cutoff playout counts as a win if it is more likely than not
+				float win = info().who_take_turns == board::black ? black : 1 - black;
+				rule->record(path[1]->place_pos, win >= 0.5f, local);
+			}
+			if(cfg.recycle && memory->full()){
+				recycle();
+			}
+			if(compact_due(cfg)){
+				compact(cfg);
+			}
+			if(counters){
+				auto t4 = tick();
+				typedef std::chrono::duration<double> seconds;
+				counters->simulations++;
+				counters->nodes += expand_node != leaf;
+				counters->depth_sum += path.size() - 1;
+				counters->depth_max = std::max<int>(counters->depth_max, path.size() - 1);
+				counters->depths[std::min<size_t>(path.size() - 1, 63)]++;
+				counters->select += seconds(t1 - t0).count();
+				counters->expand += seconds(t2 - t1).count();
+				counters->simulate += seconds(t3 - t2).count();
+				counters->backprop += seconds(t4 - t3).count();
+			}
+		}
+
+		/**
+		 * expand every legal move at once, so that the root policy may pick any of them
+		 */
+		void expand_all(std::default_random_engine& engine, const config& cfg){
+			prepare(engine, cfg);
+			while(expand_from_leaf() != this);
+		}
+
+		/**
+		 * run n simulations through the child of move, which is chosen by the root policy instead of the tree policy
+		 * the root should be expanded by expand_all
+		 */
+		void MCTS_through(int move, int n, std::default_random_engine& engine, const config& cfg,
+			search_counters* counters = nullptr){
+			uint64_t local = 0;
+			for(int i = 0; i < n; ++i){
+				node* next = child_of(move); // found again, since a compaction may move it
+				if(cfg.solver && next->proven != 0){
+					break;
 				}
-				*/
-				// select
-				//debug << "select" << std::endl;
-				std::vector<node*> path = select_root_to_leaf(info().who_take_turns, ucb_c);
-				// expand
-				//debug << "expand" << std::endl;
-				node* leaf = path.back();
-				node* expand_node = leaf->expand_from_leaf(engine);
-				if(expand_node != leaf){
-					path.push_back(expand_node);
-				}
-				// simulate
-				//debug << "simulate" << std::endl;
-				unsigned winner = path.back()->simulate_winner(engine);
-				// backpropagate
-				//debug << "backpropagate" << std::endl;
-				back_propagate(path, winner);
+				simulate_from(next, engine, cfg, nullptr, counters, local);
 			}
+		}
 
-			//debug.close();
-			return select_action();
+		/**
+		 * the child of move, or nullptr if it is not expanded
+		 */
+		node* child_of(int move){
+			for(auto &ch : child){
+				if(ch.first == move){
+					return ch.second;
+				}
+			}
+			return nullptr;
+		}
+
+		/**
+		 * the heap bytes of the move lists and children, charged to the arena once the node is prepared
+		 */
+		long footprint() const {
+			return moves.size() * (sizeof(int) + sizeof(float) + sizeof(std::pair<int, node*>));
+		}
+
+		/**
+		 * return the node and its subtree to the arena
+		 */
+		static void release(node* n){
+			for(auto &ch : n->child){
+				release(ch.second);
+			}
+			n->memory->charge(-n->footprint());
+			n->memory->destroy(n);
+		}
+
+		/**
+		 * free the subtree below this node, but keep its statistics, so it becomes a leaf again
+		 */
+		void collapse(){
+			for(auto &ch : child){
+				release(ch.second);
+			}
+			memory->charge(-footprint());
+			std::vector<std::pair<int, node*>>().swap(child);
+			std::vector<int>().swap(moves);
+			std::vector<float>().swap(move_prior);
+			prepared = false;
+		}
+
+		/**
+		 * garbage collection once the memory budget is used up: collapse the subtrees of the least visited nodes,
+		 * doubling the visit threshold until the tree takes at most 3/4 of the budget
+		 */
+		void recycle(){
+			for(int threshold = 2; memory->bytes() > memory->limit() / 4 * 3 && threshold < total_cnt; threshold *= 2){
+				collapse_below(threshold);
+			}
+			memory->collected();
+		}
+
+		void collapse_below(int threshold){
+			for(auto &ch : child){
+				if(ch.second->total_cnt < threshold){
+					ch.second->collapse();
+				}else{
+					ch.second->collapse_below(threshold);
+				}
+			}
+		}
+
+		/**
+		 * whether this root has just reached cfg.compact simulations, or 4x, 16x, ... as many
+		 */
+		bool compact_due(const config& cfg) const {
+			if(cfg.compact <= 0 || total_cnt < cfg.compact || total_cnt % cfg.compact != 0){
+				return false;
+			}
+			unsigned times = total_cnt / cfg.compact;
+			return (times & (times - 1)) == 0 && (times & 0x55555555u) != 0;
+		}
+
+		/**
+		 * move the upper tree into a contiguous block of the arena in breadth-first order, siblings by visits,
+		 * i.e., the nodes with at least cfg.compact_min visits, up to cfg.compact_nodes of them,
+		 * so the selection from the root walks through a few adjacent pages instead of the order of expansion
+		 *
+		 * this root stays in place, since the callers hold it; the search results do not change
+		 */
+		void compact(const config& cfg){
+			std::vector<node*> order, kids;
+			order.reserve(cfg.compact_nodes);
+			for(size_t k = 0; k <= order.size() && order.size() < size_t(cfg.compact_nodes); ++k){
+				node* n = k == 0 ? this : order[k - 1];
+				kids.clear();
+				for(auto &ch : n->child){
+					if(ch.second->total_cnt >= cfg.compact_min){
+						kids.push_back(ch.second);
+					}
+				}
+				std::stable_sort(kids.begin(), kids.end(), [](node* a, node* b){ return a->total_cnt > b->total_cnt; });
+				for(size_t i = 0; i < kids.size() && order.size() < size_t(cfg.compact_nodes); ++i){
+					order.push_back(kids[i]);
+				}
+			}
+			// the parent of a node is moved before it, so its parent pointer is already up to date
+			memory->relocate(order, [](node* from, node* to){
+				for(auto &ch : to->parent->child){
+					if(ch.second == from){
+						ch.second = to;
+						break;
+					}
+				}
+				for(auto &ch : to->child){
+					ch.second->parent = to;
+				}
+			});
 		}
 
 		int select_action(){
@@ -323,32 +927,49 @@ public:
 				return -1;
 			}
 
-			int max_visit = -std::numeric_limits<int>::max();
-			node* c;
+			int win = proven_win_move();
+			if(win != -1){
+				return win;
+			}
+
+			int max_visit = -std::numeric_limits<int>::max(), max_any = max_visit;
+			node* c = nullptr;
+			node* any = nullptr; // the most visited child, if every expanded child is a proven loss
 			for(auto &ch : child){
 				int tmp = ch.second->total_cnt;
+				if(tmp > max_any){
+					max_any = tmp;
+					any = ch.second;
+				}
+				if(ch.second->proven < 0 && proven == 0){
+					continue; // never choose a proven loss unless all moves lose
+				}
 				if(tmp > max_visit){
 					max_visit = tmp;
 					c = ch.second;
 				}
 			}
 			
-			return c->place_pos;
+			return (c ? c : any)->place_pos;
 		}
 
-		std::vector<node*> select_root_to_leaf(unsigned who, float ucb_c){
+		std::vector<node*> select_root_to_leaf(std::default_random_engine& engine, const config& cfg){
 			std::vector<node*> vec;
 			node* curr = this;
 			vec.push_back(curr);
+			curr->prepare(engine, cfg);
 			while(!curr->is_leaf()){
 				// select node who has the highest ucb score
 				float max_score = -std::numeric_limits<float>::max();
-				node* c;
+				node* c = nullptr;
 				if(curr->child.size() == 0){
 					break;
 				}
 				for(auto &curr_child : curr->child){
-					float tmp = (curr_child.second)->ucb(ucb_c);
+					if((curr_child.second)->proven < 0){
+						continue; // a proven loss for the player to move at curr
+					}
+					float tmp = (curr_child.second)->score(cfg);
 					
 					if(tmp > max_score){
 						max_score = tmp;
@@ -356,43 +977,33 @@ public:
 					}
 
 				}
+				if(c == nullptr){
+					break; // every move is proven to lose, curr itself is proven by now
+				}
 				vec.push_back(c);
 				curr = c;
+				curr->prepare(engine, cfg);
 			}
 
 			return vec;
 		}
 
 		bool is_leaf(){
-			int cnt = 0;
-			for(int i = 0; i < 81; i++){
-				if(board(*this).place(i) == board::legal){
-					cnt++;
-				}
-			}
 			// check if fully expanded (leaf == not fully expanded)
-			return !(cnt > 0 && child.size() == cnt);
+			return !(moves.size() > 0 && child.size() == moves.size());
 		}
 
-		node* expand_from_leaf(std::default_random_engine& engine){
-			board b = *this;
-			std::vector<int> vec = all_space(engine);
-			bool success_placed = 0;
-			int pos = -1;
-
-			for(int i = 0; i < vec.size(); ++i){
-				b = *this;
-				if(b.place(vec[i]) == board::legal && (*this).child.count(vec[i]) == 0){
-					pos = vec[i];
-					success_placed = 1;
-					break;
+		node* expand_from_leaf(){
+			// moves are expanded in the prepared order, so the next one is never expanded before
+			if(child.size() < moves.size()){
+				int pos = moves[child.size()];
+				board b = *this;
+				b.place(pos / board::size_y, pos % board::size_y);
+				node* new_node = memory->create(memory, b, pos, move_prior[child.size()]);
+				if(new_node == nullptr){
+					return this; // the memory budget is used up, simulate from the leaf instead
 				}
-			}
-
-			if(success_placed){
-				node* new_node = new node(b, pos);
-				//this->child.push_back(new_node);
-				this->child[pos] = new_node;
+				this->child.emplace_back(pos, new_node);
 				new_node->parent = this;
 				return new_node;
 			}else{
@@ -400,6 +1011,23 @@ public:
 			}
 		}
 
+		/**
+		 * the result of a playout for black, i.e., 1 for a win and 0 for a loss,
+		 * or the win probability of the static score if the playout is cut off
+		 */
+		float simulate(std::default_random_engine& engine, const config& cfg){
+			if(cfg.playout){
+				return simulate_pattern(engine, *cfg.playout, cfg);
+			}
+			if(cfg.endgame || cfg.cutoff || cfg.cutoff_margin){
+				return simulate_uniform(engine, cfg);
+			}
+			return simulate_winner(engine) == board::black;
+		}
+
+		/**
+		 * play random legal moves on the board until the player to move has no legal move, and return the winner
+		 */
 		unsigned simulate_winner(std::default_random_engine& engine){
 			board b = *this;
 			std::vector<int> vec = all_space(engine);
@@ -427,154 +1055,437 @@ public:
 			}
 		}
 
+		/**
+		 * play moves sampled by the pattern weights until the player to move has no legal move,
+		 * or until the endgame database scores it, or until the playout is cut off
+		 */
+		float simulate_pattern(std::default_random_engine& engine, const playout_policy& policy, const config& cfg){
+			position b(*this);
+			playout_sampler sampler(b, policy);
+			unsigned who = b.who_take_turns();
+			float black;
+			for(int moves = 0; sampler.total(who) != 0; ++moves){
+				if(endgame_value(b, cfg, black)){
+					return black;
+				}
+				if(cutoff_value(b, cfg, moves, black)){
+					return black;
+				}
+				sampler.place(b, sampler.sample(who, engine));
+				who = b.who_take_turns();
+			}
+			return who == board::white;
+		}
+
+		/**
+		 * play uniformly random legal moves, until the player to move has no legal move,
+		 * or until the endgame database scores it, or until the playout is cut off
+		 */
+		float simulate_uniform(std::default_random_engine& engine, const config& cfg){
+			position b(*this);
+			unsigned who = b.who_take_turns();
+			float black;
+			for(int moves = 0; b.count_legal(who) != 0; ++moves){
+				if(endgame_value(b, cfg, black)){
+					return black;
+				}
+				if(cutoff_value(b, cfg, moves, black)){
+					return black;
+				}
+				std::uniform_int_distribution<int> dist(0, b.count_legal(who) - 1);
+				const position::mask& legal = b.legal_of(who);
+				size_t i = legal._Find_first();
+				for(int k = dist(engine); k > 0; --k){
+					i = legal._Find_next(i);
+				}
+				b.place(i, who);
+				who = b.who_take_turns();
+			}
+			return who == board::white;
+		}
+
+		/**
+		 * cut the playout off after cfg.cutoff moves, or once the legal moves of one side exceed the other's by cfg.cutoff_margin,
+		 * and score it by the logistic of the score difference for black, i.e., 1 / (1 + exp(-diff / cfg.cutoff_scale)),
+		 * where the score is the legal moves of a side (its mobility), or heuristic::value
+		 */
+		static bool cutoff_value(const position& b, const config& cfg, int moves, float& black){
+			if((cfg.cutoff == 0 || moves < cfg.cutoff) && cfg.cutoff_margin == 0){
+				return false;
+			}
+			int mobility = b.count_legal(board::black) - b.count_legal(board::white);
+			if((cfg.cutoff == 0 || moves < cfg.cutoff) && std::abs(mobility) < cfg.cutoff_margin){
+				return false;
+			}
+			float diff = cfg.cutoff_heuristic ? heuristic::value(b, board::black) - heuristic::value(b, board::white) : mobility;
+			black = 1 / (1 + std::exp(-diff / cfg.cutoff_scale));
+			return true;
+		}
+
+		/**
+		 * once few legal moves remain and every empty region is in the database, score the playout by the solo moves:
+		 * if every region is playable by one side only, the player to move wins iff it has more solo moves,
+		 * otherwise the moves in the shared regions interact, and the sums only estimate the result,
+		 * so the playout is scored by the logistic of the difference, i.e., 1 / (1 + exp(-(diff - 0.5) / cfg.endgame_scale)),
+		 * where the ties still lean to the opponent
+		 */
+		static bool endgame_value(const position& b, const config& cfg, float& black){
+			if(!cfg.endgame || b.count_legal(board::black) + b.count_legal(board::white) > cfg.endgame_at){
+				return false;
+			}
+			int solo[3], shared;
+			if(!cfg.endgame->estimate(b, solo[board::black], solo[board::white], shared)){
+				return false;
+			}
+			unsigned who = b.who_take_turns();
+			int diff = solo[who] - solo[3u - who];
+			float value = shared ? 1 / (1 + std::exp(-(diff - 0.5f) / cfg.endgame_scale)) : diff > 0;
+			black = who == board::black ? value : 1 - value;
+			return true;
+		}
+
 		std::vector<int> all_space(std::default_random_engine& engine){
 			std::vector<int> vec;
-			for(int i = 0; i < 81; ++i){
+			for(int i = 0; i < board::size_x * board::size_y; ++i){
 				vec.push_back(i);
 			}
 			std::shuffle(vec.begin(), vec.end(), engine);
 			return vec;
 		}
 
-		void back_propagate(std::vector<node*>& path, unsigned winner){
-			for(int i = 0; i < path.size(); ++i){
-				path[i]->total_cnt++;
-				if(winner != (path[i]->info()).who_take_turns){
-					path[i]->win_cnt++;
-				} else {
-					path[i]->win_cnt--;
+		/**
+		 * the move which is proven to win for the player to move, or -1 if there is none
+		 */
+		int proven_win_move(){
+			for(auto &ch : child){
+				if(ch.second->proven > 0){
+					return ch.first;
 				}
 			}
+			return -1;
 		}
-	};
 
-	void delete_tree(node* root){
-		if(root->child.size() == 0){
-			delete root;
-			return ;
+		/**
+		 * update the proven results from the leaf of path back to the root
+		 * a node is a proven loss for its mover if any child wins for the player to move,
+		 * and a proven win if it has no legal move, or all its moves are expanded and proven to lose
+		 */
+		void back_propagate_proof(std::vector<node*>& path){
+			for(int i = path.size() - 1; i >= 0; --i){
+				node* n = path[i];
+				if(n->proven == 0){
+					if(n->prepared && n->moves.empty()){
+						n->proven = +1;
+					}else if(n->proven_win_move() != -1){
+						n->proven = -1;
+					}else if(n->prepared && n->child.size() == n->moves.size()){
+						bool all_lose = true;
+						for(auto &ch : n->child){
+							all_lose = all_lose && ch.second->proven < 0;
+						}
+						n->proven = all_lose ? +1 : 0;
+					}
+				}
+				if(n->proven == 0){
+					break; // nothing more can be proven above an unknown node
+				}
+			}
 		}
 
-		for(auto &c : root->child){
-			if(c.second != nullptr){
-				delete_tree(c.second);
+		/**
+		 * add the playout result for black to the nodes of path, as +1 for a win and -1 for a loss of the player who moved into a node
+		 */
+		void back_propagate(std::vector<node*>& path, float black){
+			for(int i = 0; i < path.size(); ++i){
+				path[i]->total_cnt++;
+				float win = (path[i]->info()).who_take_turns == board::white ? black : 1 - black;
+				path[i]->win_cnt += 2 * win - 1;
 			}
 		}
+	};
 
-		delete root;
+	/**
+	 * the first root whose result is proven, or nullptr if none is
+	 */
+	node* proven_root(const std::vector<node*>& root_vec){
+		for (auto &root : root_vec) {
+			if (root->proven != 0) {
+				return root;
+			}
+		}
+		return nullptr;
 	}
 
-private:
-	std::vector<action::place> space;
-	board::piece_type who;
-};
-
-class heuristic {
-public:
+	void delete_tree(node* root){
+		node::release(root);
+	}
 
-	inline static int value(board& b, board::piece_type who) noexcept {
-		constexpr int EYE_SCORE = 16;
-		constexpr int LIBERTY_SCORE = 1;
-		constexpr int ATARI_SCORE = 8;
-		constexpr int SELF_CORNER_ADJACENT_SCORE = 4;
-		int score = 0;
-		for (int y = 0; y < board::size_y; y++)
-			for (int x = 0; x < board::size_x; x++)
-				score +=
-					+ EYE_SCORE                  * is_eye(b, x, y, who)
-					+ LIBERTY_SCORE              * count_liberty(b, x, y)
-					+ ATARI_SCORE                * is_atari(b, x, y, who)
-					+ SELF_CORNER_ADJACENT_SCORE * count_corner_adjacent(b, x, y, who);
-		return score;
+	/**
+	 * release the tree of each thread by the thread itself, the threads should be set by omp_set_num_threads
+	 */
+	void delete_trees(std::vector<node*>& root_vec) {
+		if (pool) { // no thread team of its own
+			for (auto &root : root_vec) {
+				if (root) delete_tree(root);
+				root = nullptr;
+			}
+			return;
+		}
+		#pragma omp parallel
+		{
+			int id = omp_get_thread_num();
+			if (id < int(root_vec.size()) && root_vec[id] != nullptr) {
+				delete_tree(root_vec[id]);
+				root_vec[id] = nullptr;
+			}
+		}
 	}
 
-	inline static int action_value(board& b, int x, int y, board::piece_type who) noexcept {
-		constexpr int EYE_SCORE = 16;
-		constexpr int LIBERTY_SCORE = 8;
-		constexpr int ATARI_SCORE = 24;
-		constexpr int SELF_CORNER_ADJACENT_SCORE = 8;
-		constexpr int OPPO_CORNER_ADJACENT_SCORE = 1;
-		constexpr int OPPO_SIDE_ADJACENT_SCORE = 1;
-		constexpr int BLOCK_OPPO_SCORE = 24;
-		//constexpr int SELF_CAN_PLAY_SCORE = 32;
-		int score =
-			- EYE_SCORE                  * is_eye(b, x, y, who)
-			+ LIBERTY_SCORE              * count_liberty(b, x, y)
-			+ ATARI_SCORE                * is_atari(b, x, y, who)
-			+ SELF_CORNER_ADJACENT_SCORE * count_corner_adjacent(b, x, y, who)
-			+ OPPO_CORNER_ADJACENT_SCORE * count_corner_adjacent(b, x, y, board::piece_type(3u - who))
-			+ OPPO_SIDE_ADJACENT_SCORE   * count_side_adjacent(b, x, y, board::piece_type(3u - who));
-
-		int before_count_available_place = count_available_place(b, board::piece_type(3u - who));
-		//int before_count_only_one_can_place = count_only_one_can_place(b, who);
-		auto autoundo = b.temporary();
-		autoundo.place(x, y, who);
-		int after_count_available_place = count_available_place(b, board::piece_type(3u - who));
-		//int after_count_only_one_can_place = count_only_one_can_place(b, who);
+	/**
+	 * keep the root children and the principal variation of the trees, e.g., for the trace and the analysis,
+	 * the variation follows the most visited move summed over the trees
+	 */
+	void record_trees(const std::vector<node*>& roots) {
+		const int cells = board::size_x * board::size_y;
+		std::vector<search_trace::child> merged(cells, search_trace::child());
+		for (auto &root : roots) {
+			for (auto &ch : root->child) {
+				search_trace::child& m = merged[ch.first];
+				m.move = ch.first;
+				m.visits += ch.second->total_cnt;
+				m.wins += std::lround((ch.second->total_cnt + ch.second->win_cnt) / 2); // win_cnt is wins - losses
+				if (ch.second->proven) m.proven = ch.second->proven;
+			}
+		}
+		report.root.clear();
+		for (auto &m : merged) {
+			if (m.visits) report.root.push_back(m);
+		}
 
-		score += EYE_SCORE * (
-			+ is_eye(b, x, y - 1, who)
-			+ is_eye(b, x - 1, y, who)
-			+ is_eye(b, x + 1, y, who)
-			+ is_eye(b, x, y + 1, who)
-		);
-		score += BLOCK_OPPO_SCORE    * (before_count_available_place - after_count_available_place);
-		//score += SELF_CAN_PLAY_SCORE * (after_count_only_one_can_place - before_count_only_one_can_place);
-		return score;
+		report.pv.clear();
+		std::vector<node*> at(roots.begin(), roots.end());
+		while (report.pv.size() < 64) {
+			std::vector<uint32_t> visits(cells, 0);
+			for (node* n : at) {
+				if (!n) continue;
+				for (auto &ch : n->child) visits[ch.first] += ch.second->total_cnt;
+			}
+			int best = std::max_element(visits.begin(), visits.end()) - visits.begin();
+			if (visits[best] == 0) break;
+			report.pv.push_back(best);
+			for (node*& n : at) n = n ? n->child_of(best) : nullptr;
+		}
 	}
 
-	inline static bool is_eye(const board& b, int x, int y, board::piece_type who) noexcept {
-		if (x < 0 || x >= board::size_x || y < 0 || y >= board::size_y || b[x][y] != board::empty) return false;
-		return (x + 0 < 0 || x + 0 >= board::size_x || y - 1 < 0 || y - 1 >= board::size_y || b[x + 0][y - 1] == who || b[x + 0][y - 1] == board::hollow)
-			&& (x - 1 < 0 || x - 1 >= board::size_x || y + 0 < 0 || y + 0 >= board::size_y || b[x - 1][y + 0] == who || b[x - 1][y + 0] == board::hollow)
-			&& (x + 1 < 0 || x + 1 >= board::size_x || y + 0 < 0 || y + 0 >= board::size_y || b[x + 1][y + 0] == who || b[x + 1][y + 0] == board::hollow)
-			&& (x + 0 < 0 || x + 0 >= board::size_x || y + 1 < 0 || y + 1 >= board::size_y || b[x + 0][y + 1] == who || b[x + 0][y + 1] == board::hollow);
+	/**
+	 * the search threads: threads=K, or one per CPU of cpus=list (e.g., cpus=0-7,16-23), or one per processor
+	 */
+	int search_threads() {
+		if (cpus.empty()) {
+			cpus = cpu_set_of(option("cpus", std::string()));
+			if (cpus.empty()) throw std::invalid_argument("empty cpu set");
+			for (int cpu : cpus) numa.push_back(numa_node_of(cpu)); // read once, for the stats of pinned threads
+		}
+		int threads = option("threads", 0);
+		if (threads > 0) return threads;
+		return meta.find("cpus") != meta.end() ? int(cpus.size()) : omp_get_num_procs();
 	}
 
-	inline static int count_liberty(const board& b, int x, int y) noexcept {
-		return (x + 0 >= 0 && x + 0 < board::size_x && y - 1 >= 0 && y - 1 < board::size_y && b[x + 0][y - 1] == board::empty)
-			 + (x - 1 >= 0 && x - 1 < board::size_x && y + 0 >= 0 && y + 0 < board::size_y && b[x - 1][y + 0] == board::empty)
-			 + (x + 1 >= 0 && x + 1 < board::size_x && y + 0 >= 0 && y + 0 < board::size_y && b[x + 1][y + 0] == board::empty)
-			 + (x + 0 >= 0 && x + 0 < board::size_x && y + 1 >= 0 && y + 1 < board::size_y && b[x + 0][y + 1] == board::empty);
+	/**
+	 * with pin=1, pin thread id to the id-th CPU of the cpu set, so its tree arena stays on the local NUMA node
+	 */
+	void bind_thread(int id) {
+		if (option("pin", 0)) {
+			pin_thread(cpus[id % cpus.size()]);
+		}
 	}
 
-	inline static bool is_atari(const board& b, int x, int y, board::piece_type who) noexcept {
-		return (x + 0 < 0 || x + 0 >= board::size_x || y - 1 < 0 || y - 1 >= board::size_y || b[x + 0][y - 1] == 3u - who || b[x + 0][y - 1] == board::hollow)
-			 + (x - 1 < 0 || x - 1 >= board::size_x || y + 0 < 0 || y + 0 >= board::size_y || b[x - 1][y + 0] == 3u - who || b[x - 1][y + 0] == board::hollow)
-			 + (x + 1 < 0 || x + 1 >= board::size_x || y + 0 < 0 || y + 0 >= board::size_y || b[x + 1][y + 0] == 3u - who || b[x + 1][y + 0] == board::hollow)
-			 + (x + 0 < 0 || x + 0 >= board::size_x || y + 1 < 0 || y + 1 >= board::size_y || b[x + 0][y + 1] == 3u - who || b[x + 0][y + 1] == board::hollow)
-			== 3 && count_liberty(b, x, y) == 1;
+	/**
+	 * the memory of the trees after the last search, summed over all threads
+	 */
+	struct tree_usage {
+		size_t nodes = 0;       // the live nodes
+		size_t bytes = 0;       // the bytes of the live nodes and their move lists
+		size_t peak = 0;        // the most bytes ever taken by a tree, summed over the trees
+		size_t reserved = 0;    // the bytes of the arena chunks, which bound the resident memory
+		size_t collections = 0; // the garbage collections so far
+		size_t compactions = 0; // the compactions of the upper trees so far
+	};
+	const tree_usage& memory_usage() const { return usage; }
+
+	/**
+	 * one tree arena per thread, kept between moves, each with an equal share of the budget mem (in MB, 0 for no limit)
+	 */
+	void prepare_arenas(int thread_num) {
+		while (int(arenas.size()) < thread_num) {
+			arenas.emplace_back(new arena<node>());
+		}
+		size_t limit = size_t(option("mem", 0.0) * (1 << 20) / thread_num);
+		for (auto &a : arenas) {
+			a->limit(limit ? std::max<size_t>(limit, 1 << 20) : 0);
+		}
 	}
 
-	inline static int count_corner_adjacent(const board& b, int x, int y, board::piece_type who) noexcept {
-		return (x - 1 >= 0 && x - 1 < board::size_x && y - 1 >= 0 && y - 1 < board::size_y && b[x - 1][y - 1] == who)
-			 + (x + 1 >= 0 && x + 1 < board::size_x && y - 1 >= 0 && y - 1 < board::size_y && b[x + 1][y - 1] == who)
-			 + (x - 1 >= 0 && x - 1 < board::size_x && y + 1 >= 0 && y + 1 < board::size_y && b[x - 1][y + 1] == who)
-			 + (x + 1 >= 0 && x + 1 < board::size_x && y + 1 >= 0 && y + 1 < board::size_y && b[x + 1][y + 1] == who);
+	void record_usage() {
+		usage = tree_usage();
+		for (auto &a : arenas) {
+			usage.nodes += a->size();
+			usage.bytes += a->bytes();
+			usage.peak += a->peak();
+			usage.reserved += a->reserved();
+			usage.collections += a->collected_times();
+			usage.compactions += a->relocated_times();
+		}
 	}
 
-	inline static int count_side_adjacent(const board& b, int x, int y, board::piece_type who) noexcept {
-		return (x + 0 >= 0 && x + 0 < board::size_x && y - 1 >= 0 && y - 1 < board::size_y && b[x + 0][y - 1] == who)
-			 + (x - 1 >= 0 && x - 1 < board::size_x && y + 0 >= 0 && y + 0 < board::size_y && b[x - 1][y + 0] == who)
-			 + (x + 1 >= 0 && x + 1 < board::size_x && y + 0 >= 0 && y + 0 < board::size_y && b[x + 1][y + 0] == who)
-			 + (x + 0 >= 0 && x + 0 < board::size_x && y + 1 >= 0 && y + 1 < board::size_y && b[x + 0][y + 1] == who);
-	}
+	/**
+	 * sequential halving at the root: the budget of N simulations per thread is split into log2(m) rounds,
+	 * each round spreads its share evenly over the remaining candidates, and only the better half survives,
+	 * which spends the simulations on telling the best moves apart instead of on the UCB exploration
+	 *
+	 * with gumbel=1, the m candidates (halving_m, default 16) are sampled without replacement by Gumbel noise
+	 * plus the log prior, and the survivors are ranked by noise + log prior + (50 + max visit) * win rate,
+	 * otherwise all moves are candidates (or the first halving_m in the prior order), ranked by the win rate
+	 * the trees below the candidates still follow the tree policy
+	 */
+	action sequential_halving(const board& state, int N, const config& c) {
+		int thread_num = search_threads();
+		omp_set_num_threads(thread_num);
+		std::vector<node*> root_vec(thread_num);
+		std::vector<std::default_random_engine> engines;
+		prepare_arenas(thread_num);
+		for (int i = 0; i < thread_num; ++i) {
+			engines.emplace_back(engine());
+		}
+		// step(id) until it returns true, by the thread team, or on the shared pool taking turns with the other searches
+		auto each_tree = [&](const std::function<bool(int)>& step) {
+			if (pool) {
+				pool->run(thread_num, step);
+				return;
+			}
+			#pragma omp parallel
+			{
+				int id = omp_get_thread_num();
+				bind_thread(id);
+				while (!step(id));
+			}
+		};
+		each_tree([&](int id) {
+			root_vec[id] = arenas[id]->create(arenas[id].get(), state);
+			root_vec[id]->expand_all(engines[id], c);
+			return true;
+		});
+		auto cleanup = [&]() {
+			record_usage();
+			record_trees(root_vec);
+			delete_trees(root_vec);
+		};
+		report.source = "halving";
+		report.budget = uint64_t(N) * thread_num;
+		report.threads.assign(thread_num, search_counters());
+
+		// the moves expanded in every tree
+		node* first = root_vec[0];
+		std::vector<int> candidates;
+		for (auto &ch : first->child) {
+			bool everywhere = true;
+			for (auto &root : root_vec) {
+				everywhere &= root->child_of(ch.first) != nullptr;
+			}
+			if (everywhere) candidates.push_back(ch.first);
+		}
+		if (candidates.empty()) {
+			cleanup();
+			return action();
+		}
+		bool gumbel = option("gumbel", 0);
+		size_t m = option("halving_m", gumbel ? 16 : 0);
+		std::vector<float> noise(board::size_x * board::size_y, 0), logit(board::size_x * board::size_y, 0);
+		if (gumbel) {
+			std::uniform_real_distribution<float> uniform(1e-6f, 1.0f);
+			for (int move : candidates) {
+				noise[move] = -std::log(-std::log(uniform(engine)));
+				logit[move] = std::log(std::max(first->child_of(move)->prior, 1e-6f));
+			}
+			std::stable_sort(candidates.begin(), candidates.end(),
+				[&](int a, int b) { return noise[a] + logit[a] > noise[b] + logit[b]; });
+		}
+		if (m && candidates.size() > m) {
+			candidates.resize(m); // the prior order, or the Gumbel top-m
+		}
 
-	inline static int count_only_one_can_place(const board& b, board::piece_type who) noexcept {
-		int count = 0;
-		for (int y = 0; y < board::size_y; y++)
-			for (int x = 0; x < board::size_x; x++)
-				count += (b.test(x, y, who) == board::legal) && (b.test(x, y, 3u - who) != board::legal);
-		return count;
-	}
+		int rounds = std::max(1, int(std::ceil(std::log2(candidates.size()))));
+		std::vector<int> visit(board::size_x * board::size_y);
+		std::vector<float> win(board::size_x * board::size_y);
+		while (true) {
+			int n = std::max(1, int(N / rounds / candidates.size()));
+			int chunk = pool ? option("pool_chunk", 256) : n * int(candidates.size());
+			std::vector<size_t> next(thread_num, 0); // the simulations of the round done by each tree, candidate by candidate
+			each_tree([&](int id) {
+				for (int budget = chunk; budget > 0 && next[id] < candidates.size() * n; ) {
+					int k = std::min<int>(budget, n - next[id] % n);
+					root_vec[id]->MCTS_through(candidates[next[id] / n], k, engines[id], c, &report.threads[id]);
+					next[id] += k;
+					budget -= k;
+				}
+				return next[id] == candidates.size() * n;
+			});
+
+			// merge the trees, play a proven win at once, and drop the proven losses
+			int max_visit = 0;
+			std::vector<int> survivors;
+			for (int move : candidates) {
+				visit[move] = win[move] = 0;
+				bool lost = false;
+				for (auto &root : root_vec) {
+					node* ch = root->child_of(move);
+					if (c.solver && ch->proven > 0) {
+						cleanup();
+						return action::place(move, state.info().who_take_turns);
+					}
+					lost |= c.solver && ch->proven < 0;
+					visit[move] += ch->total_cnt;
+					win[move] += ch->win_cnt;
+				}
+				max_visit = std::max(max_visit, visit[move]);
+				if (!lost) survivors.push_back(move);
+			}
+			if (survivors.empty()) { // every move loses, keep searching the candidates anyway
+				survivors = candidates;
+			}
+
+			auto score = [&](int move) {
+				float q = visit[move] ? win[move] / visit[move] : -1;
+				return gumbel ? noise[move] + logit[move] + (50 + max_visit) * q : q;
+			};
+			std::stable_sort(survivors.begin(), survivors.end(), [&](int a, int b) { return score(a) > score(b); });
+			if (survivors.size() <= 1 || candidates.size() <= 2) {
+				candidates.swap(survivors);
+				break;
+			}
+			survivors.resize((survivors.size() + 1) / 2);
+			candidates.swap(survivors);
+		}
 
-	inline static int count_available_place(const board& b, board::piece_type who) noexcept {
-		int count = 0;
-		for (int y = 0; y < board::size_y; y++)
-			for (int x = 0; x < board::size_x; x++)
-				count += b.test(x, y, who) == board::legal;
-		return count;
+		int best = candidates.front();
+		cleanup();
+		return action::place(best, state.info().who_take_turns);
 	}
 
+private:
+	std::vector<action::place> space;
+	board::piece_type who;
+	std::shared_ptr<playout_policy> policy;
+	std::shared_ptr<dfpn_solver> solver;
+	std::shared_ptr<endgame_db> endgame;
+	std::shared_ptr<search_trace> trace;
+	search_pool* pool = nullptr;
+	uint32_t games = 0;
+	std::vector<std::unique_ptr<arena<node>>> arenas;
+	std::vector<int> cpus;
+	std::vector<int> numa; // the NUMA node of each CPU of cpus
+	tree_usage usage;
+	search_report report;
 };
 
 class heuristic_agent : public random_agent {
@@ -593,18 +1504,19 @@ public:
 
 	virtual action take_action(const board& state, int steps) {
 		
-		if (who == board::black && state.test(4, 4, who) == board::legal)
-			return action::place(40, who);
+		const board::point center(board::size_x / 2, board::size_y / 2);
+		if (who == board::black && state.test(center.x, center.y, who) == board::legal)
+			return action::place(center, who);
 		
 		std::shuffle(space.begin(), space.end(), engine);
 		int max_index = -1;
 		int max_score = -9999;
-		board after = state;
+		position after(state);
 		for (int i = 0, end = space.size(); i < end; i++) {
 			const action::place& move = space[i];
 			board::point p = move.position();
-			if (state.test(p.x, p.y, who) == board::legal) {
-				int score = heuristic::action_value(after, p.x, p.y, who);
+			if (after.legal(p.i, who)) {
+				int score = heuristic::action_value(after, p.i, who);
 				if (score > max_score) {
 					max_index = i;
 					max_score = score;
@@ -612,10 +1524,14 @@ public:
 			}
 		}
 		
-		auto i = space[max_index].position().i;
-		if (!(i == 4 || i == 36 || i == 44 || i == 76)) {
-			if (state.test(4, 4, who) == board::legal)
-				return action::place(40, who);
+		if (max_index == -1) return action(); // no legal move
+
+		board::point p = space[max_index].position(); // the outer ends of the hollow arms are kept
+		bool arm_end = (p.x == center.x && (p.y == 0 || p.y == board::size_y - 1))
+		            || (p.y == center.y && (p.x == 0 || p.x == board::size_x - 1));
+		if (!arm_end) {
+			if (state.test(center.x, center.y, who) == board::legal)
+				return action::place(center, who);
 		}
 		
 		return max_index == -1 ? action() : space[max_index];
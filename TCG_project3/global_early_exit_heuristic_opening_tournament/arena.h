@@ -0,0 +1,144 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * arena.h: Pooled allocation of search tree nodes under a memory budget
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <new>
+#include <sys/mman.h>
+
+/**
+ * objects are carved from chunks of slots, and the destroyed slots are reused through a free list,
+ * the chunks are kept until the arena is destroyed, so a tree of the same size never allocates again
+ *
+ * the chunks are mapped directly from the kernel, so their pages are placed on the NUMA node of the thread
+ * which touches them first, i.e., the search thread which owns the arena (see player::bind_thread)
+ *
+ * the arena counts the bytes of the live objects, and also the heap bytes charged by them (e.g., their vectors),
+ * create() returns nullptr once the bytes reach the limit (0 for no limit)
+ *
+ * the objects are placed in the order of creation, so relocate() may move the hot ones (e.g., the upper tree)
+ * together into a contiguous block later
+ */
+template<typename type>
+class arena {
+public:
+	arena(size_t limit = 0, size_t chunk = 4096) : cap(limit), chunk(chunk), next(nullptr), end(nullptr), vacant(nullptr),
+		live(0), used(0), most(0), collections(0), relocations(0) {}
+	~arena() {
+		for (auto& c : chunks) munmap(c.first, c.second * sizeof(slot));
+	}
+	arena(const arena&) = delete;
+	arena& operator =(const arena&) = delete;
+
+	template<typename... args>
+	type* create(args&&... a) {
+		if (full()) return nullptr;
+		slot* s;
+		if (vacant) {
+			s = vacant;
+			vacant = vacant->next;
+		} else {
+			if (next == end) grow();
+			s = next++;
+		}
+		live++;
+		charge(sizeof(type));
+		return new (s) type(std::forward<args>(a)...);
+	}
+
+	void destroy(type* p) {
+		p->~type();
+		vacate(reinterpret_cast<slot*>(p));
+		live--;
+		charge(-long(sizeof(type)));
+	}
+
+	/**
+	 * move the objects, in the given order, into one contiguous block of new slots,
+	 * fix(from, to) is called after each move so the owner can redirect its pointers (from is not valid by then),
+	 * and the old slots are reused by the following creations; the counts and the bytes are unchanged
+	 */
+	template<typename fixer>
+	void relocate(const std::vector<type*>& objects, fixer fix) {
+		if (objects.empty()) return;
+		if (size_t(end - next) < objects.size()) grow(objects.size());
+		for (type* from : objects) {
+			type* to = new (next++) type(std::move(*from));
+			from->~type();
+			vacate(reinterpret_cast<slot*>(from));
+			fix(from, to);
+		}
+		relocations++;
+	}
+
+	/**
+	 * count the heap bytes owned by the objects, negative to release them
+	 */
+	void charge(long bytes) {
+		used += bytes;
+		most = std::max(most, used);
+	}
+
+	bool full() const { return cap && used >= cap; }
+	void limit(size_t bytes) { cap = bytes; }
+	size_t limit() const { return cap; }
+
+	size_t size() const { return live; }
+	size_t bytes() const { return used; }
+	size_t peak() const { return most; }
+	size_t reserved() const {
+		size_t slots = 0;
+		for (auto& c : chunks) slots += c.second;
+		return slots * sizeof(slot);
+	}
+
+	void collected() { collections++; }
+	size_t collected_times() const { return collections; }
+	size_t relocated_times() const { return relocations; }
+
+private:
+	union slot {
+		slot* next;
+		typename std::aligned_storage<sizeof(type), alignof(type)>::type storage;
+	};
+
+	void vacate(slot* s) {
+		s->next = vacant;
+		vacant = s;
+	}
+
+	/**
+	 * map a new chunk of at least the given slots, the rest of the current chunk goes to the free list
+	 */
+	void grow(size_t slots = 0) {
+		while (next != end) vacate(next++);
+		slots = std::max(slots, chunk);
+		void* c = mmap(nullptr, slots * sizeof(slot), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (c == MAP_FAILED) throw std::bad_alloc();
+		chunks.emplace_back(static_cast<slot*>(c), slots);
+		next = chunks.back().first;
+		end = next + slots;
+	}
+
+	size_t cap;
+	size_t chunk;
+	std::vector<std::pair<slot*, size_t>> chunks; // the chunks and their slots
+	slot* next;
+	slot* end;
+	slot* vacant;
+	size_t live;
+	size_t used;
+	size_t most;
+	size_t collections;
+	size_t relocations;
+};
@@ -0,0 +1,335 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * bench.cpp: Perft counts and micro-benchmarks of the board operations and the search
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include "board.h"
+#include "action.h"
+#include "position.h"
+#include "agent.h"
+
+/**
+ * the fixed positions, as the moves from the empty board
+ * the games are on the 9x9 board, so the other sizes have only the empty board
+ */
+const std::vector<std::pair<std::string, std::string>>& fixed_positions() {
+	static const std::vector<std::pair<std::string, std::string>> positions = {
+		{ "empty", "" },
+#if BOARD_SIZE == 9
+		{ "opening", "G7 A7 D3 H6 E5 D4 F8 E6 G4 J8" },
+		{ "middle", "G7 A7 D3 H6 E5 D4 F8 E6 G4 J8 A9 F2 B8 D9 H3 E1 E9 A2 B7 A6 J9 A3 F6 D8 D7 B1 F5 H2 C2 B2" },
+		{ "endgame", "G7 A7 D3 H6 E5 D4 F8 E6 G4 J8 A9 F2 B8 D9 H3 E1 E9 A2 B7 A6 J9 A3 F6 D8 D7 B1 F5 H2 C2 B2 "
+		             "J1 G8 J3 B3 C6 C4 G9 B9 G2 C1 G6 J5 F3 F1 J6 C9 D1 H1 C7 A1" },
+#endif
+	};
+	return positions;
+}
+
+board position_of(const std::string& moves) {
+	board b;
+	std::stringstream ss(moves);
+	for (std::string move; ss >> move; ) {
+		if (b.place(board::point(move)) != board::legal) throw std::invalid_argument("illegal fixed move: " + move);
+	}
+	return b;
+}
+
+/**
+ * the leaves of the legal move tree, by board::test and board::place
+ */
+uint64_t perft(const board& b, int depth) {
+	if (depth == 0) return 1;
+	uint64_t leaves = 0;
+	for (int i = 0; i < board::size_x * board::size_y; i++) {
+		board::point p(i);
+		if (b.test(p.x, p.y) != board::legal) continue;
+		board after = b;
+		after.place(p);
+		leaves += perft(after, depth - 1);
+	}
+	return leaves;
+}
+
+/**
+ * the leaves of the legal move tree, by the legal moves kept in position
+ */
+uint64_t perft(const position& b, int depth) {
+	if (depth == 0) return 1;
+	const position::mask& legal = b.legal_of(b.who_take_turns());
+	if (depth == 1) return legal.count();
+	uint64_t leaves = 0;
+	for (size_t i = legal._Find_first(); i < position::cells; i = legal._Find_next(i)) {
+		position after = b;
+		after.place(i);
+		leaves += perft(after, depth - 1);
+	}
+	return leaves;
+}
+
+/**
+ * the time per operation, where run() does some operations and returns how many
+ * run() is repeated until min_time seconds have passed
+ */
+template<typename function>
+double nanoseconds_per_op(function run, double min_time) {
+	typedef std::chrono::steady_clock clock;
+	uint64_t ops = 0;
+	auto start = clock::now();
+	double elapsed = 0;
+	do {
+		ops += run();
+		elapsed = std::chrono::duration<double>(clock::now() - start).count();
+	} while (elapsed < min_time);
+	return elapsed * 1e9 / std::max<uint64_t>(ops, 1);
+}
+
+/**
+ * the results by name, compared with the baseline if any
+ * the units ending with "/s" are better when larger, the other timings are better when smaller,
+ * and the counts ("leaves" and "positions") must match exactly
+ */
+class results {
+public:
+	bool load(const std::string& path) {
+		std::ifstream in(path);
+		if (!in.is_open()) return false;
+		for (std::string name, unit; in >> name; ) {
+			double value;
+			in >> value >> unit;
+			baseline[name] = value;
+		}
+		return true;
+	}
+
+	void add(const std::string& name, double value, const std::string& unit) {
+		rows.push_back({ name, unit });
+		values[name] = value;
+		bool count = unit == "leaves" || unit == "positions";
+		std::cout << std::left << std::setw(32) << name << std::right << std::setw(16) << std::fixed
+		          << std::setprecision(count ? 0 : 1) << value << " " << std::left << std::setw(10) << unit;
+		auto it = baseline.find(name);
+		if (it != baseline.end()) {
+			std::cout << " "; // the units may fill the column
+			if (count) {
+				bool same = uint64_t(it->second) == uint64_t(value);
+				mismatch |= !same;
+				std::cout << (same ? "ok" : "MISMATCH, baseline " + std::to_string(uint64_t(it->second)));
+			} else {
+				bool rate = unit.size() > 2 && unit.substr(unit.size() - 2) == "/s";
+				double speedup = rate ? value / it->second : it->second / value;
+				std::cout << std::setprecision(2) << "x" << speedup << (speedup >= 1 ? " faster" : " slower");
+			}
+		}
+		std::cout << std::right << std::endl;
+	}
+
+	void save(const std::string& path) const {
+		std::ofstream out(path, std::ios::out | std::ios::trunc);
+		for (auto& row : rows) out << row.first << " " << std::fixed << std::setprecision(1) << values.at(row.first) << " " << row.second << std::endl;
+	}
+
+	bool matched() const { return !mismatch; }
+
+private:
+	std::map<std::string, double> baseline;
+	std::map<std::string, double> values;
+	std::vector<std::pair<std::string, std::string>> rows;
+	bool mismatch = false;
+};
+
+int main(int argc, const char* argv[]) {
+	std::cout << "HollowNoGo-Bench: ";
+	std::copy(argv, argv + argc, std::ostream_iterator<const char*>(std::cout, " "));
+	std::cout << std::endl << std::endl;
+
+	int depth = 3, N = 1000;
+	double min_time = 0.5;
+	std::string search_args, baseline_path, save_path, only;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		auto match_arg = [&](std::string flag) -> bool {
+			auto it = arg.find_first_not_of('-');
+			return arg.find(flag, it) == it;
+		};
+		auto next_opt = [&]() -> std::string {
+			auto it = arg.find('=') + 1;
+			return it ? arg.substr(it) : argv[++i];
+		};
+		if (match_arg("depth")) {
+			depth = std::stoi(next_opt());
+		} else if (match_arg("time")) {
+			min_time = std::stod(next_opt());
+		} else if (match_arg("N")) {
+			N = std::stoi(next_opt());
+		} else if (match_arg("search")) {
+			search_args = next_opt();
+		} else if (match_arg("baseline")) {
+			baseline_path = next_opt();
+		} else if (match_arg("save")) {
+			save_path = next_opt();
+		} else if (match_arg("only")) {
+			only = next_opt();
+		}
+	}
+
+	results res;
+	if (baseline_path.size() && !res.load(baseline_path)) {
+		std::cerr << "cannot open baseline: " << baseline_path << std::endl;
+		return 1;
+	}
+
+	std::vector<board> boards;
+	std::vector<position> positions;
+	for (auto& p : fixed_positions()) {
+		boards.push_back(position_of(p.second));
+		positions.push_back(boards.back());
+	}
+	typedef std::chrono::steady_clock clock;
+	auto seconds_since = [](clock::time_point start) { return std::chrono::duration<double>(clock::now() - start).count(); };
+
+	// perft: the legal move trees by both representations must agree
+	bool agreed = true;
+	if (only.empty() || only == "perft") {
+		for (size_t k = 0; k < boards.size(); k++) {
+			const std::string& name = fixed_positions()[k].first;
+			auto start = clock::now();
+			uint64_t leaves = perft(boards[k], depth);
+			double board_time = seconds_since(start);
+			start = clock::now();
+			uint64_t fast = perft(positions[k], depth);
+			double position_time = seconds_since(start);
+			if (fast != leaves) {
+				std::cout << "perft " << name << ": board " << leaves << " != position " << fast << std::endl;
+				agreed = false;
+			}
+			std::string prefix = "perft/" + name + "/" + std::to_string(depth);
+			res.add(prefix, leaves, "leaves");
+			res.add(prefix + "/board", board_time * 1e9 / std::max<uint64_t>(leaves, 1), "ns/leaf");
+			res.add(prefix + "/position", position_time * 1e9 / std::max<uint64_t>(leaves, 1), "ns/leaf");
+		}
+	}
+
+	// micro-benchmarks over all the points of the fixed positions
+	if (only.empty() || only == "micro") {
+		volatile int sink = 0;
+		const int cells = board::size_x * board::size_y;
+		res.add("board::place", nanoseconds_per_op([&]() {
+			uint64_t ops = 0;
+			for (const board& b : boards) {
+				for (int i = 0; i < cells; i++) {
+					board after = b;
+					sink += after.place(board::point(i));
+					ops++;
+				}
+			}
+			return ops;
+		}, min_time), "ns/op");
+		res.add("board::test", nanoseconds_per_op([&]() {
+			uint64_t ops = 0;
+			for (const board& b : boards) {
+				for (int i = 0; i < cells; i++) {
+					board::point p(i);
+					sink += b.test(p.x, p.y);
+					ops++;
+				}
+			}
+			return ops;
+		}, min_time), "ns/op");
+		res.add("board::check_liberty", nanoseconds_per_op([&]() {
+			uint64_t ops = 0;
+			for (const board& b : boards) {
+				for (int i = 0; i < cells; i++) {
+					board::point p(i);
+					unsigned who = b[p.x][p.y];
+					if (who != board::black && who != board::white) continue;
+					sink += b.check_liberty(p.x, p.y, who);
+					ops++;
+				}
+			}
+			return ops;
+		}, min_time), "ns/op");
+		res.add("heuristic::action_value", nanoseconds_per_op([&]() {
+			uint64_t ops = 0;
+			for (const position& b : positions) {
+				const position::mask& legal = b.legal_of(b.who_take_turns());
+				for (size_t i = legal._Find_first(); i < position::cells; i = legal._Find_next(i)) {
+					sink += heuristic::action_value(b, i, b.who_take_turns());
+					ops++;
+				}
+			}
+			return ops;
+		}, min_time), "ns/op");
+
+		player searcher("name=bench role=black threads=1 N=" + std::to_string(N) + " " + search_args);
+		player::config cfg = searcher.search_config();
+		std::default_random_engine engine(0);
+		arena<player::node> memory;
+		player::node* root = memory.create(&memory, boards[0]);
+		double playout = nanoseconds_per_op([&]() {
+			for (int k = 0; k < 100; k++) sink += root->simulate(engine, cfg);
+			return 100;
+		}, min_time);
+		searcher.delete_tree(root);
+		res.add("node::simulate", 1e9 / playout, "playouts/s");
+
+		for (size_t k = 0; k < boards.size(); k++) {
+			if (positions[k].count_legal(positions[k].who_take_turns()) == 0) continue;
+			const std::string& name = fixed_positions()[k].first;
+			player p("name=bench role=" + std::string(boards[k].info().who_take_turns == board::black ? "black" : "white")
+				+ " threads=1 N=" + std::to_string(N) + " " + search_args);
+			uint64_t simulations = 0, searches = 0;
+			double msec = nanoseconds_per_op([&]() {
+				sink += p.take_action(boards[k], 0).event();
+				for (auto& t : p.last_search().threads) simulations += t.simulations;
+				searches++;
+				return 1;
+			}, min_time) / 1e6;
+			res.add("player::take_action/" + name, msec, "ms");
+			res.add("player::take_action/" + name + "/rate", simulations / (msec * searches / 1e3), "playouts/s");
+		}
+	}
+
+	// df-pn: every proven win must come with a legal move, over the endgames of seeded random games
+	// that stop at 4 to 23 legal moves in total, so some are won by a move that leaves the opponent no move
+	if (only.empty() || only == "dfpn") {
+		uint64_t solved = 0, wins = 0;
+		dfpn_solver solver(1 << 16);
+		for (int k = 0; k < 50; k++) {
+			std::default_random_engine engine(k);
+			position pos;
+			while (pos.count_legal(board::black) + pos.count_legal(board::white) >= 4 + k % 20) {
+				const position::mask& legal = pos.legal_of(pos.who_take_turns());
+				std::vector<int> moves;
+				for (size_t i = legal._Find_first(); i < position::cells; i = legal._Find_next(i)) moves.push_back(i);
+				pos.place(moves[std::uniform_int_distribution<size_t>(0, moves.size() - 1)(engine)]);
+			}
+			int move;
+			dfpn_solver::result r = solver.solve(pos.state(), move, 200000, 1 << 30);
+			solved += r != dfpn_solver::unknown;
+			if (r != dfpn_solver::win) continue;
+			wins++;
+			if (move < 0 || !pos.legal(move, pos.who_take_turns())) {
+				std::cout << "dfpn game " << k << ": win with illegal move " << move << std::endl;
+				agreed = false;
+			}
+		}
+		res.add("dfpn/solved", solved, "positions");
+		res.add("dfpn/wins", wins, "positions");
+	}
+
+	if (save_path.size()) res.save(save_path);
+	return agreed && res.matched() ? 0 : 1;
+}
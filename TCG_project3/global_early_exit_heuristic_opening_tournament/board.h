@@ -41,10 +41,18 @@
  *
  * for 9x9 Hollow NoGo, the empty locations are hollow but not empty, cannot be counted as liberty,
  * i.e., there are also borders at the center of the board
+ *
+ * the geometry is fixed at compile time by BOARD_SIZE (9 by default, e.g., make SIZE=7 or make SIZE=11),
+ * the hollow arms always run along the center lines from the border (exclusive) to the 3x3 center (exclusive),
+ * so the 7x7 board has 4 hollow points and the 11x11 board has 12; all sizes between 5 and 15 are supported
  */
+#ifndef BOARD_SIZE
+#define BOARD_SIZE 9
+#endif
 class board {
 public:
-	enum size { size_x = 9u, size_y = 9u, hollow_x = 3u, hollow_y = 3u };
+	enum size { size_x = BOARD_SIZE, size_y = BOARD_SIZE };
+	static_assert(BOARD_SIZE >= 5 && BOARD_SIZE <= 15 && BOARD_SIZE % 2 == 1, "the board size should be odd, from 5 to 15");
 	enum piece_type { empty = 0u, black = 1u, white = 2u, hollow = 3u, unknown = -1u };
 	typedef uint32_t cell;
 	typedef std::array<cell, size_y> column;
@@ -119,7 +127,7 @@ public:
 		if (x == -1 && y == -1) return nogo_move_result::illegal_pass;
 		point p_min(0, 0), p_max(size_x - 1, size_y - 1);
 		if (x < p_min.x || x > p_max.x || y < p_min.y || y > p_max.y) return nogo_move_result::illegal_out_of_range;
-		if (board::initial()[x][y] == piece_type::hollow)             return nogo_move_result::illegal_out_of_range;
+		if (is_hollow(x, y))                                          return nogo_move_result::illegal_out_of_range;
 		board test = *this;
 		if (test[x][y] != piece_type::empty) return nogo_move_result::illegal_not_empty;
 		test[x][y] = who; // try put a piece first
@@ -143,7 +151,7 @@ public:
 		if (x == -1 && y == -1) return nogo_move_result::illegal_pass;
 		point p_min(0, 0), p_max(size_x - 1, size_y - 1);
 		if (x < p_min.x || x > p_max.x || y < p_min.y || y > p_max.y) return nogo_move_result::illegal_out_of_range;
-		if (board::initial()[x][y] == piece_type::hollow)             return nogo_move_result::illegal_out_of_range;
+		if (is_hollow(x, y))                                          return nogo_move_result::illegal_out_of_range;
 		board test = *this;
 		if (test[x][y] != piece_type::empty) return nogo_move_result::illegal_not_empty;
 		test[x][y] = who; // try put a piece first
@@ -264,6 +272,14 @@ public:
 	void rotate_left() { transpose(); reflect_horizontal(); } // counterclockwise
 	void reverse() { reflect_horizontal(); reflect_vertical(); }
 
+	/**
+	 * whether [x][y] is a hollow point, which folds into a constant wherever x and y are known
+	 */
+	static constexpr bool is_hollow(int x, int y) {
+		return (x == size_x / 2 && y > 0 && y < size_y - 1 && (y < size_y / 2 - 1 || y > size_y / 2 + 1))
+		    || (y == size_y / 2 && x > 0 && x < size_x - 1 && (x < size_x / 2 - 1 || x > size_x / 2 + 1));
+	}
+
 public:
 	friend std::ostream& operator <<(std::ostream& out, const board& b) {
 		std::ios ff(nullptr);
@@ -328,14 +344,11 @@ protected:
 	static const grid& initial() { static grid stone; return stone; }
 	static __attribute__((constructor)) void init_initial_scheme() {
 		grid& stone = const_cast<grid&>(initial());
-		stone[4][1] = piece_type::hollow;
-		stone[4][2] = piece_type::hollow;
-		stone[4][6] = piece_type::hollow;
-		stone[4][7] = piece_type::hollow;
-		stone[1][4] = piece_type::hollow;
-		stone[2][4] = piece_type::hollow;
-		stone[6][4] = piece_type::hollow;
-		stone[7][4] = piece_type::hollow;
+		for (int x = 0; x < size_x; x++) {
+			for (int y = 0; y < size_y; y++) {
+				if (is_hollow(x, y)) stone[x][y] = piece_type::hollow;
+			}
+		}
 	}
 private:
 	grid stone;
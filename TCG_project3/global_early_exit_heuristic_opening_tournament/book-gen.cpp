@@ -0,0 +1,205 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * book-gen.cpp: Offline builder of the opening book
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <regex>
+#include <omp.h>
+#include "board.h"
+#include "action.h"
+#include "agent.h"
+#include "book.h"
+
+/**
+ * the visits and wins of each move of a position, the moves are in the canonical image
+ */
+struct move_stats {
+	std::map<int, std::pair<uint64_t, uint64_t>> moves; // move -> (visits, wins)
+	bool searched = false;
+};
+typedef std::unordered_map<uint64_t, move_stats> book_stats;
+
+/**
+ * add the moves of a recorded game, e.g., an SGF file saved by gogui-twogtp, up to depth plies
+ * the winner is read from RE[B+...] or RE[W+...], or else the player of the last move
+ */
+bool absorb_game(const std::string& path, size_t depth, book_stats& stats) {
+	std::ifstream in(path);
+	if (!in.is_open()) return false;
+	std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	std::vector<action::place> moves;
+	std::regex token(action::place::syntax());
+	for (auto it = std::sregex_iterator(text.begin(), text.end(), token); it != std::sregex_iterator(); it++) {
+		std::stringstream ss(it->str());
+		action::place move;
+		ss >> move;
+		moves.push_back(move);
+	}
+	if (moves.empty()) return false;
+	unsigned winner = moves.back().color();
+	std::smatch result;
+	if (std::regex_search(text, result, std::regex("RE\\[([BW])\\+"))) winner = result[1] == "B" ? board::black : board::white;
+
+	position pos;
+	for (size_t k = 0; k < moves.size() && k < depth; k++) {
+		unsigned who = pos.who_take_turns();
+		int i = moves[k].position().i;
+		if (moves[k].color() != who || i < 0 || !pos.legal(i, who)) break;
+		auto& s = stats[pos.canonical_hash()].moves[position::symmetric(i, pos.canonical_symmetry())];
+		s.first += 1;
+		s.second += who == winner;
+		pos.place(i, who);
+	}
+	return true;
+}
+
+/**
+ * run root-parallel MCTS on all cores, and add the visits and wins of the root moves
+ * return the most visited move in the orientation of pos
+ */
+int search(player& searcher, const position& pos, int N, unsigned seed, move_stats& stats) {
+	player::config cfg = searcher.search_config();
+	int canon = pos.canonical_symmetry();
+	std::vector<uint64_t> visits(position::cells, 0), wins(position::cells, 0);
+	#pragma omp parallel
+	{
+		std::default_random_engine engine(seed + omp_get_thread_num());
+		arena<player::node> memory;
+		player::node* root = memory.create(&memory, pos.state());
+		root->MCTS(N, engine, cfg);
+		#pragma omp critical
+		for (auto& c : root->child) {
+			visits[c.first] += c.second->total_cnt;
+			wins[c.first] += (c.second->total_cnt + c.second->win_cnt) / 2; // win_cnt is wins - losses
+		}
+		searcher.delete_tree(root);
+	}
+	int best = -1;
+	for (int i = 0; i < position::cells; i++) {
+		if (!visits[i]) continue;
+		auto& s = stats.moves[position::symmetric(i, canon)];
+		s.first += visits[i];
+		s.second += wins[i];
+		if (best == -1 || visits[i] > visits[best]) best = i;
+	}
+	stats.searched = true;
+	return best;
+}
+
+/**
+ * the book entries: the most visited move of every searched position,
+ * and of the positions from the games with enough games behind the move
+ */
+std::vector<opening_book::entry> make_book(const book_stats& stats, uint64_t min_games) {
+	std::vector<opening_book::entry> book;
+	for (const auto& s : stats) {
+		int best = -1;
+		uint64_t visits = 0, wins = 0;
+		for (const auto& m : s.second.moves) {
+			if (m.second.first > visits) best = m.first, visits = m.second.first, wins = m.second.second;
+		}
+		if (best == -1 || (!s.second.searched && visits < min_games)) continue;
+		opening_book::entry e;
+		e.key = s.first;
+		e.visits = std::min<uint64_t>(visits, UINT32_MAX);
+		e.value = wins * 65535 / visits;
+		e.move = best;
+		e.source = s.second.searched ? opening_book::from_search : opening_book::from_games;
+		book.push_back(e);
+	}
+	return book;
+}
+
+int main(int argc, const char* argv[]) {
+	std::cout << "HollowNoGo-BookGen: ";
+	std::copy(argv, argv + argc, std::ostream_iterator<const char*>(std::cout, " "));
+	std::cout << std::endl << std::endl;
+
+	size_t depth = 4;
+	uint64_t min_games = 8;
+	unsigned seed = 0;
+	std::string search_args, save_path = "book.db";
+	std::vector<std::string> games;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		auto match_arg = [&](std::string flag) -> bool {
+			auto it = arg.find_first_not_of('-');
+			return arg.find(flag, it) == it;
+		};
+		auto next_opt = [&]() -> std::string {
+			auto it = arg.find('=') + 1;
+			return it ? arg.substr(it) : argv[++i];
+		};
+		if (arg[0] != '-') { // the recorded games
+			games.push_back(arg);
+		} else if (match_arg("depth")) {
+			depth = std::stoull(next_opt());
+		} else if (match_arg("min-games")) {
+			min_games = std::stoull(next_opt());
+		} else if (match_arg("seed")) {
+			seed = std::stoul(next_opt());
+		} else if (match_arg("search")) {
+			search_args = next_opt();
+		} else if (match_arg("save")) {
+			save_path = next_opt();
+		}
+	}
+
+	book_stats stats;
+	size_t absorbed = 0;
+	for (const std::string& path : games) absorbed += absorb_game(path, depth, stats);
+	std::cout << absorbed << " games absorbed, " << stats.size() << " positions" << std::endl;
+
+	player searcher("name=book role=black N=100000 " + search_args);
+	int N = std::stoi(searcher.property("N"));
+
+	// the book covers both colors: the positions of ply p are where the book side is to move,
+	// the book move is searched, and every reply of the opponent leads to the positions of ply p + 2
+	std::vector<std::vector<position>> frontier(depth + 2);
+	frontier[0].push_back(position());
+	position::mask first = frontier[0][0].unique_legal_of(board::black);
+	for (size_t i = first._Find_first(); i < position::cells; i = first._Find_next(i)) {
+		position after = frontier[0][0];
+		after.place(i);
+		frontier[1].push_back(after);
+	}
+
+	size_t searched = 0;
+	for (size_t ply = 0; ply < depth; ply++) {
+		for (const position& pos : frontier[ply]) {
+			move_stats& s = stats[pos.canonical_hash()];
+			if (s.searched) continue; // a transposition or a symmetric position
+			int best = search(searcher, pos, N, seed + searched * 1009, s);
+			searched++;
+			if (best == -1) continue;
+
+			position after = pos;
+			after.place(best);
+			position::mask replies = after.unique_legal_of(after.who_take_turns());
+			for (size_t i = replies._Find_first(); i < position::cells; i = replies._Find_next(i)) {
+				position next = after;
+				next.place(i);
+				frontier[ply + 2].push_back(next);
+			}
+		}
+		opening_book::save(save_path, make_book(stats, min_games)); // save each ply, the search may take hours
+		std::cout << "ply " << ply << ": " << frontier[ply].size() << " positions, " << searched << " searched" << std::endl;
+	}
+
+	std::vector<opening_book::entry> book = make_book(stats, min_games);
+	opening_book::save(save_path, book);
+	std::cout << book.size() << " positions saved to " << save_path << std::endl;
+	return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * book.h: Memory-mapped opening book keyed by the canonical Zobrist key
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "board.h"
+#include "position.h"
+
+/**
+ * the book move of each position, stored in the canonical image of the position (see position::canonical_symmetry),
+ * so one entry serves all 8 symmetric positions
+ *
+ * the file is a header followed by the entries sorted by key, and a lookup is a binary search on the mapped file
+ * the book is built offline by book-gen, see book-gen.cpp
+ */
+class opening_book {
+public:
+	struct header {
+		char magic[8];
+		uint32_t version;
+		uint32_t size;
+	};
+	struct entry {
+		uint64_t key;    // position::canonical_hash of the position
+		uint32_t visits; // the simulations or games behind the move
+		uint16_t value;  // the win rate of the move for the player to move, scaled to 0 ~ 65535
+		uint8_t move;    // the move in the canonical image
+		uint8_t source;  // how the move was found
+	};
+	enum source_type { from_search = 0, from_games = 1 };
+	static constexpr const char* magic() { return "NOGOBOOK"; }
+
+	opening_book() : map(nullptr), length(0), entries(nullptr), size(0) {}
+	~opening_book() { close(); }
+	opening_book(const opening_book&) = delete;
+	opening_book& operator =(const opening_book&) = delete;
+
+	bool open(const std::string& path) {
+		close();
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+		struct stat st;
+		if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(header)) {
+			void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+			if (addr != MAP_FAILED) map = addr, length = st.st_size;
+		}
+		::close(fd);
+		if (!map) return false;
+
+		const header* h = static_cast<const header*>(map);
+		if (std::strncmp(h->magic, magic(), 8) != 0 || h->version != 1
+			|| length < sizeof(header) + size_t(h->size) * sizeof(entry)) {
+			close();
+			return false;
+		}
+		entries = reinterpret_cast<const entry*>(h + 1);
+		size = h->size;
+		return true;
+	}
+
+	void close() {
+		if (map) munmap(map, length);
+		map = nullptr;
+		entries = nullptr;
+		size = 0;
+	}
+
+	bool is_open() const { return map != nullptr; }
+	size_t positions() const { return size; }
+
+	/**
+	 * the book move of the player to move, mapped back to the orientation of state, or false if not in the book
+	 */
+	bool probe(const board& state, int& move) const {
+		if (!entries) return false;
+		position pos(state);
+		uint64_t key = pos.canonical_hash();
+		const entry* e = std::lower_bound(entries, entries + size, key,
+			[](const entry& e, uint64_t key) { return e.key < key; });
+		if (e == entries + size || e->key != key) return false;
+		move = position::inverse_symmetric(e->move, pos.canonical_symmetry());
+		return pos.legal(move, pos.who_take_turns());
+	}
+
+	/**
+	 * write the entries as a book file, the entries are sorted by key
+	 */
+	static void save(const std::string& path, std::vector<entry> book) {
+		std::sort(book.begin(), book.end(), [](const entry& a, const entry& b) { return a.key < b.key; });
+		header h = {};
+		std::copy_n(magic(), 8, h.magic);
+		h.version = 1;
+		h.size = book.size();
+		std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		out.write(reinterpret_cast<const char*>(book.data()), book.size() * sizeof(entry));
+		out.close();
+		if (!out) throw std::runtime_error("cannot write " + path);
+	}
+
+private:
+	void* map;
+	size_t length;
+	const entry* entries;
+	size_t size;
+};
@@ -0,0 +1,199 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * dfpn.h: Depth-first proof-number search for the endgame of Hollow NoGo
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include "board.h"
+#include "position.h"
+
+/**
+ * df-pn solver in the negamax form
+ *
+ * the proof number of a position is the cost to prove that the player to move wins,
+ * and the disproof number is the cost to prove that the player to move loses, so that
+ *   pn(n) = min over children of dn(c), dn(n) = sum over children of pn(c)
+ * a player without any legal move loses, i.e., pn = inf and dn = 0
+ *
+ * an unvisited child starts with pn = 1 and dn = its number of legal moves (df-pn+),
+ * and the 1 + epsilon trick widens the threshold of the best child to reduce the switching between children
+ *
+ * the numbers are kept in a two-way transposition table indexed by the canonical Zobrist key, so the
+ * symmetric positions share one entry, the table is kept between searches,
+ * and the search gives up when the node or time budget runs out
+ */
+class dfpn_solver {
+public:
+	enum result { unknown = 0, win = 1, loss = -1 };
+	typedef uint32_t number;
+	enum : number { inf = 1u << 30, unset = ~0u };
+
+	/**
+	 * tt_size: entries of the transposition table, rounded down to a power of 2 (at least one bucket)
+	 */
+	dfpn_solver(size_t tt_size = 1 << 20) {
+		size_t size = 2;
+		while (size * 2 <= tt_size) size *= 2;
+		table.assign(size, { 0, 1, 1, 0 });
+		mask = size - 2;
+		generation = 0;
+	}
+
+	/**
+	 * solve the position for the player to move, within the budget of nodes and milliseconds
+	 * return win with the winning move, loss, or unknown if the budget runs out
+	 * (or if the winning move cannot be recovered from the table), so a win always comes with a legal move
+	 */
+	result solve(const board& state, int& move, size_t max_nodes, int max_msec) {
+		position root(state);
+		nodes = 0;
+		node_limit = max_nodes;
+		deadline = clock::now() + std::chrono::milliseconds(max_msec);
+		aborted = false;
+		generation++;
+
+		number pn, dn;
+		mid(root, inf - 1, inf - 1, pn, dn);
+		move = -1;
+		if (pn == 0) {
+			unsigned who = root.who_take_turns();
+			for (int i = 0; i < position::cells; i++) {
+				entry e;
+				if (!root.legal(i, who)) continue;
+				position after = root;
+				after.place(i, who);
+				if (after.count_legal(3u - who) == 0 || (lookup(root.canonical_hash_after(i, who), e) && e.dn == 0)) {
+					move = i;
+					break;
+				}
+			}
+			return move >= 0 ? win : unknown; // the winning child may have been replaced in the table
+		}
+		return dn == 0 ? loss : unknown;
+	}
+
+	size_t searched() const { return nodes; }
+
+private:
+	struct entry {
+		uint64_t key;
+		number pn, dn;
+		uint32_t generation;
+		bool proven() const { return pn == 0 || dn == 0; }
+	};
+
+	bool lookup(uint64_t key, entry& e) const {
+		const entry* bucket = &table[key & mask];
+		for (int k = 0; k < 2; k++) {
+			if (bucket[k].key == key) {
+				e = bucket[k];
+				return true;
+			}
+		}
+		return false;
+	}
+	/**
+	 * replace the entry of the same key, or else the entry left by an older search, or else an unproven one
+	 */
+	void store(uint64_t key, number pn, number dn) {
+		entry* bucket = &table[key & mask];
+		entry* slot = &bucket[1];
+		if (bucket[0].key == key || (bucket[1].key != key && (bucket[0].generation != generation
+			|| (!bucket[0].proven() && bucket[1].generation == generation)))) slot = &bucket[0];
+		*slot = { key, pn, dn, generation };
+	}
+
+	static number add(number a, number b) { return std::min<number>(a + b, inf); }
+
+	bool out_of_budget() {
+		if (aborted) return true;
+		if (nodes >= node_limit) aborted = true;
+		if ((nodes & 1023) == 0 && clock::now() > deadline) aborted = true;
+		return aborted;
+	}
+
+	/**
+	 * multiple iterative deepening: search until pn >= th_pn or dn >= th_dn
+	 */
+	void mid(const position& pos, number th_pn, number th_dn, number& pn, number& dn) {
+		nodes++;
+		uint64_t key = pos.canonical_hash();
+		unsigned who = pos.who_take_turns();
+
+		int moves[position::cells], num = 0;
+		uint64_t keys[position::cells];
+		number init_dn[position::cells]; // the legal moves of the opponent after each move, counted on the first miss
+		auto initial = [&](int k) -> number {
+			if (init_dn[k] == unset) {
+				position after = pos;
+				after.place(moves[k], who);
+				init_dn[k] = after.count_legal(3u - who);
+			}
+			return init_dn[k];
+		};
+		for (int i = 0; i < position::cells; i++) {
+			if (pos.legal(i, who)) {
+				moves[num] = i;
+				keys[num] = pos.canonical_hash_after(i, who);
+				init_dn[num] = unset;
+				entry c;
+				if (!lookup(keys[num], c) && initial(num) == 0)
+					store(keys[num], inf, 0); // proven without a visit, keep it for the parent
+				num++;
+			}
+		}
+		if (num == 0) {
+			pn = inf; dn = 0;
+			store(key, pn, dn);
+			return;
+		}
+
+		while (true) {
+			// collect the numbers of children, where the best child has the smallest disproof number
+			pn = inf; dn = 0;
+			number second = inf;
+			int best = -1;
+			for (int k = 0; k < num; k++) {
+				entry c;
+				if (!lookup(keys[k], c)) c = { keys[k], initial(k) ? 1u : number(inf), initial(k), generation }; // also if replaced by the recursion
+				dn = add(dn, c.pn);
+				if (c.dn < pn) {
+					second = pn;
+					pn = c.dn;
+					best = k;
+				} else if (c.dn < second) {
+					second = c.dn;
+				}
+			}
+			if (pn >= th_pn || dn >= th_dn || out_of_budget()) break;
+
+			entry c;
+			if (!lookup(keys[best], c)) c.pn = 1;
+			number child_th_pn = std::min<number>(th_dn - dn + c.pn, inf - 1); // the child's proof number raises our disproof number
+			number child_th_dn = std::min(th_pn, add(second, second / 4 + 1)); // 1 + epsilon, epsilon = 1/4
+			position after = pos;
+			after.place(moves[best], who);
+			number cpn, cdn;
+			mid(after, child_th_pn, child_th_dn, cpn, cdn);
+		}
+		store(key, pn, dn);
+	}
+
+private:
+	typedef std::chrono::steady_clock clock;
+	std::vector<entry> table;
+	size_t mask;
+	uint32_t generation;
+	size_t nodes;
+	size_t node_limit;
+	clock::time_point deadline;
+	bool aborted;
+};
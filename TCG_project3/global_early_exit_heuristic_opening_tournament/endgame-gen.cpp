@@ -0,0 +1,163 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * endgame-gen.cpp: Offline generator of the endgame database
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <set>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include "endgame.h"
+
+typedef std::vector<std::pair<int, int>> shape;
+
+/**
+ * all fixed polyominoes of 1 ~ max_cells cells, normalized to start at (0, 0)
+ */
+std::vector<shape> enumerate_shapes(int max_cells) {
+	auto normalize = [](shape s) {
+		int minx = s[0].first, miny = s[0].second;
+		for (auto& c : s) minx = std::min(minx, c.first), miny = std::min(miny, c.second);
+		for (auto& c : s) c.first -= minx, c.second -= miny;
+		std::sort(s.begin(), s.end());
+		return s;
+	};
+	std::vector<shape> shapes;
+	std::set<shape> last = { shape{ { 0, 0 } } };
+	for (int n = 1; n <= max_cells; n++) {
+		shapes.insert(shapes.end(), last.begin(), last.end());
+		std::set<shape> grown;
+		for (const shape& s : last) {
+			for (const auto& c : s) {
+				const int dx[] = { 0, -1, 1, 0 }, dy[] = { -1, 0, 0, 1 };
+				for (int k = 0; k < 4; k++) {
+					std::pair<int, int> p(c.first + dx[k], c.second + dy[k]);
+					if (std::find(s.begin(), s.end(), p) != s.end()) continue;
+					shape t = s;
+					t.push_back(p);
+					grown.insert(normalize(t));
+				}
+			}
+		}
+		last.swap(grown);
+	}
+	return shapes;
+}
+
+/**
+ * the points around a shape, in an arbitrary but fixed order
+ */
+shape ring_of(const shape& s) {
+	shape ring;
+	for (const auto& c : s) {
+		const int dx[] = { 0, -1, 1, 0 }, dy[] = { -1, 0, 0, 1 };
+		for (int k = 0; k < 4; k++) {
+			std::pair<int, int> p(c.first + dx[k], c.second + dy[k]);
+			if (std::find(s.begin(), s.end(), p) == s.end() && std::find(ring.begin(), ring.end(), p) == ring.end())
+				ring.push_back(p);
+		}
+	}
+	return ring;
+}
+
+/**
+ * emit every configuration of the shape that is its own canonical form, so each class is solved once
+ */
+void solve_shape(const shape& s, std::vector<uint64_t>& out) {
+	shape ring = ring_of(s);
+	size_t total = 1;
+	for (size_t k = 0; k < ring.size(); k++) total *= local_region::states;
+	std::vector<int> states(ring.size(), 0);
+	for (size_t n = 0; n < total; n++) {
+		size_t code = n;
+		for (size_t k = 0; k < ring.size(); k++) states[k] = code % local_region::states, code /= local_region::states;
+
+		local_region local;
+		for (const auto& c : s) local.add(c.first, c.second, local_region::empty);
+		for (size_t k = 0; k < ring.size(); k++) local.add(ring[k].first, ring[k].second, states[k]);
+
+		uint64_t key = local.key_of();
+		if (key != local.canonical_key()) continue;
+		int black = local.solo_moves(board::black), white = local.solo_moves(board::white);
+		out.push_back(endgame_db::pack(key, black, white));
+	}
+}
+
+int main(int argc, const char* argv[]) {
+	std::cout << "HollowNoGo-EndgameGen: ";
+	std::copy(argv, argv + argc, std::ostream_iterator<const char*>(std::cout, " "));
+	std::cout << std::endl << std::endl;
+
+	int cells = 4;
+	size_t threads = std::max(1u, std::thread::hardware_concurrency());
+	std::string save_path = "endgame.db";
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		auto match_arg = [&](std::string flag) -> bool {
+			auto it = arg.find_first_not_of('-');
+			return arg.find(flag, it) == it;
+		};
+		auto next_opt = [&]() -> std::string {
+			auto it = arg.find('=') + 1;
+			return it ? arg.substr(it) : argv[++i];
+		};
+		if (match_arg("cells")) {
+			cells = std::stoi(next_opt());
+		} else if (match_arg("threads")) {
+			threads = std::max<size_t>(1, std::stoull(next_opt()));
+		} else if (match_arg("save")) {
+			save_path = next_opt();
+		}
+	}
+	if (cells < 1 || cells > local_region::max_cells)
+		throw std::invalid_argument("cells should be 1 ~ " + std::to_string(int(local_region::max_cells)));
+
+	std::vector<shape> shapes = enumerate_shapes(cells);
+	// the shapes with larger rings take most of the time, so hand them out in round-robin
+	std::sort(shapes.begin(), shapes.end(), [](const shape& a, const shape& b) { return ring_of(a).size() > ring_of(b).size(); });
+	std::vector<std::vector<uint64_t>> found(threads);
+	std::vector<std::thread> workers;
+	for (size_t t = 0; t < threads; t++) {
+		workers.emplace_back([&, t]() {
+			for (size_t k = t; k < shapes.size(); k += threads) solve_shape(shapes[k], found[t]);
+		});
+	}
+	for (std::thread& w : workers) w.join();
+
+	size_t count = 0;
+	for (const auto& f : found) count += f.size();
+	uint64_t slots = 2;
+	while (slots < count * 2) slots *= 2; // keep the load factor at most 1/2
+	std::vector<uint64_t> table(slots, 0);
+	for (const auto& f : found) {
+		for (uint64_t entry : f) {
+			uint64_t key = entry & ((uint64_t(1) << 56) - 1);
+			uint64_t i = endgame_db::slot_of(key) & (slots - 1);
+			while (table[i]) i = (i + 1) & (slots - 1);
+			table[i] = entry;
+		}
+	}
+
+	endgame_db::header h = {};
+	std::copy_n(endgame_db::magic(), 8, h.magic);
+	h.version = 1;
+	h.max_cells = cells;
+	h.slots = slots;
+	std::ofstream out(save_path, std::ios::out | std::ios::binary | std::ios::trunc);
+	out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(uint64_t));
+	out.close();
+	if (!out) throw std::runtime_error("cannot write " + save_path);
+
+	std::cout << shapes.size() << " shapes, " << count << " configurations, " << slots << " slots saved to " << save_path << std::endl;
+	return 0;
+}
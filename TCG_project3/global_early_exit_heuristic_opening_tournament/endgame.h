@@ -0,0 +1,367 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * endgame.h: Endgame database of small independent empty regions
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "board.h"
+#include "position.h"
+
+/**
+ * a local configuration: a connected region of empty points, and the points around it
+ *
+ * a point around the region is the edge (the outside or a hollow point), or a stone, which is
+ *   alive:   its block has liberties outside the region, so moves in the region never take its last liberty
+ *   bounded: all liberties of its block are in the region, next to this stone
+ * the value of a region is the number of moves each side can play in it alone (solo moves),
+ * i.e., the longest sequence of legal moves of one side in the region while the other side plays elsewhere
+ */
+class local_region {
+public:
+	enum { max_cells = 5, max_ring = 2 * max_cells + 2, span = max_cells + 2 };
+	enum state { edge = 0, black_alive = 1, white_alive = 2, black_bounded = 3, white_bounded = 4, states = 5, empty = 7 };
+
+	struct cell { int x, y, s; };
+
+	local_region() : n(0) {}
+
+	void add(int x, int y, int s) { cells[n++] = { x, y, s }; }
+	int size() const { return n; }
+
+	/**
+	 * the key of this configuration, the same for all 8 symmetric configurations
+	 * 0 if the region is empty or larger than max_cells
+	 */
+	uint64_t canonical_key() const {
+		uint64_t key = 0;
+		for (int t = 0; t < 8; t++) {
+			uint64_t k = key_of(t);
+			if (k == 0) return 0;
+			if (key == 0 || k < key) key = k;
+		}
+		return key;
+	}
+
+	/**
+	 * the key of this configuration as it is, under the t-th symmetry (t = 0 is the identity)
+	 *
+	 * bits 0 ~ 5 are the width and height of the region, then one bit per point of its bounding box
+	 * marks the region, then 3 bits per point around the region (in row-major order) for its state
+	 */
+	uint64_t key_of(int t = 0) const {
+		int count = 0, minx = 1 << 20, miny = 1 << 20, maxx = -(1 << 20), maxy = -(1 << 20);
+		cell moved[max_cells + max_ring];
+		for (int i = 0; i < n; i++) {
+			moved[i] = transform(cells[i], t);
+			if (moved[i].s != empty) continue;
+			count++;
+			minx = std::min(minx, moved[i].x); maxx = std::max(maxx, moved[i].x);
+			miny = std::min(miny, moved[i].y); maxy = std::max(maxy, moved[i].y);
+		}
+		if (count == 0 || count > max_cells) return 0;
+
+		int grid[span][span]; // shifted by one, so the points around the region are inside
+		for (auto& row : grid) for (auto& g : row) g = edge;
+		int w = maxx - minx + 1, h = maxy - miny + 1;
+		for (int i = 0; i < n; i++) grid[moved[i].x - minx + 1][moved[i].y - miny + 1] = moved[i].s;
+
+		uint64_t key = w | (h << 3);
+		int bit = 6;
+		for (int y = 0; y < h; y++)
+			for (int x = 0; x < w; x++, bit++)
+				if (grid[x + 1][y + 1] == empty) key |= uint64_t(1) << bit;
+		for (int y = 0; y <= h + 1; y++) {
+			for (int x = 0; x <= w + 1; x++) {
+				if (grid[x][y] == empty || !next_to_region(grid, x, y, w, h)) continue;
+				key |= uint64_t(grid[x][y]) << bit;
+				bit += 3;
+			}
+		}
+		return key;
+	}
+
+	/**
+	 * the number of solo moves of who in this region
+	 */
+	int solo_moves(unsigned who) {
+		build_graph();
+		int memo[1 << max_cells];
+		std::fill(memo, memo + (1 << max_cells), -1);
+		return longest(0, who, memo);
+	}
+
+public:
+	static cell transform(cell c, int t) {
+		if (t & 4) std::swap(c.x, c.y);
+		if (t & 1) c.x = -c.x;
+		if (t & 2) c.y = -c.y;
+		return c;
+	}
+
+	static bool next_to_region(const int (&grid)[span][span], int x, int y, int w, int h) {
+		const int dx[] = { 0, -1, 1, 0 }, dy[] = { -1, 0, 0, 1 };
+		for (int k = 0; k < 4; k++) {
+			int nx = x + dx[k], ny = y + dy[k];
+			if (nx >= 1 && nx <= w && ny >= 1 && ny <= h && grid[nx][ny] == empty) return true;
+		}
+		return false;
+	}
+
+private:
+	/**
+	 * the region points as 0 ~ r - 1, and for each region point, its neighbors in the region
+	 * and the stones around it (bounded stones keep the set of region points they touch)
+	 */
+	void build_graph() {
+		r = 0;
+		for (int i = 0; i < n; i++) if (cells[i].s == empty) index[i] = r++;
+		for (int i = 0; i < n; i++) {
+			if (cells[i].s != empty) continue;
+			int a = index[i];
+			near_empty[a] = near_alive[a][0] = near_alive[a][1] = 0;
+			num_bounded[a] = 0;
+			for (int j = 0; j < n; j++) {
+				if (std::abs(cells[i].x - cells[j].x) + std::abs(cells[i].y - cells[j].y) != 1) continue;
+				int s = cells[j].s;
+				if (s == empty) near_empty[a] |= 1u << index[j];
+				else if (s == black_alive || s == white_alive) near_alive[a][s - black_alive] = 1;
+				else if (s == black_bounded || s == white_bounded) {
+					unsigned touch = 0;
+					for (int k = 0; k < n; k++)
+						if (cells[k].s == empty && std::abs(cells[j].x - cells[k].x) + std::abs(cells[j].y - cells[k].y) == 1)
+							touch |= 1u << index[k];
+					bounded[a][num_bounded[a]++] = { unsigned(s - black_bounded + 1), touch };
+				}
+			}
+		}
+	}
+
+	int longest(unsigned mask, unsigned who, int* memo) const {
+		if (memo[mask] != -1) return memo[mask];
+		int best = 0;
+		for (int p = 0; p < r; p++) {
+			if (mask & (1u << p)) continue;
+			if (legal(mask, p, who)) best = std::max(best, 1 + longest(mask | (1u << p), who, memo));
+		}
+		return memo[mask] = best;
+	}
+
+	/**
+	 * whether who can place at p, where mask marks the region points already taken by who
+	 */
+	bool legal(unsigned mask, int p, unsigned who) const {
+		unsigned after = mask | (1u << p);
+		unsigned free = ((1u << r) - 1) & ~after;
+		// the block of p inside the region, also connected through own bounded stones
+		unsigned block = 1u << p, grow = block;
+		while (grow) {
+			unsigned next = 0;
+			for (int q = 0; q < r; q++) {
+				if (!(grow & (1u << q))) continue;
+				next |= near_empty[q];
+				for (int k = 0; k < num_bounded[q]; k++)
+					if (bounded[q][k].who == who) next |= bounded[q][k].touch;
+			}
+			next &= after & ~block;
+			block |= next;
+			grow = next;
+		}
+		bool alive = false;
+		for (int q = 0; q < r; q++) {
+			if (!(block & (1u << q))) continue;
+			if (near_empty[q] & free) alive = true;
+			if (near_alive[q][who - 1]) alive = true;
+			for (int k = 0; k < num_bounded[q]; k++) // an own bounded stone joins the block with its liberties
+				if (bounded[q][k].who == who && (bounded[q][k].touch & free)) alive = true;
+		}
+		if (!alive) return false; // suicide
+		for (int k = 0; k < num_bounded[p]; k++) // take the last liberty of an opponent bounded stone
+			if (bounded[p][k].who != who && !(bounded[p][k].touch & free)) return false;
+		return true;
+	}
+
+private:
+	int n;
+	cell cells[max_cells + max_ring];
+
+	struct stone { unsigned who, touch; };
+	int r;
+	int index[max_cells + max_ring];
+	unsigned near_empty[max_cells];
+	unsigned near_alive[max_cells][2];
+	stone bounded[max_cells][4];
+	int num_bounded[max_cells];
+};
+
+/**
+ * the memory-mapped table from local_region::canonical_key to the solo moves of both sides
+ *
+ * the file is a header followed by an open-addressing hash table of 64-bit slots,
+ * each slot is key | (black solo moves << 56) | (white solo moves << 60), and an unused slot is 0
+ * the table is built offline by endgame-gen, see endgame-gen.cpp
+ */
+class endgame_db {
+public:
+	struct header {
+		char magic[8];
+		uint32_t version;
+		uint32_t max_cells;
+		uint64_t slots;
+	};
+	static constexpr const char* magic() { return "NOGOEDB"; }
+
+	endgame_db() : map(nullptr), length(0), slots(nullptr), mask(0), cells(0) {}
+	~endgame_db() { close(); }
+	endgame_db(const endgame_db&) = delete;
+	endgame_db& operator =(const endgame_db&) = delete;
+
+	bool open(const std::string& path) {
+		close();
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+		struct stat st;
+		if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(header)) {
+			void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+			if (addr != MAP_FAILED) map = addr, length = st.st_size;
+		}
+		::close(fd);
+		if (!map) return false;
+
+		const header* h = static_cast<const header*>(map);
+		if (std::strncmp(h->magic, magic(), 8) != 0 || h->version != 1
+			|| h->slots == 0 || (h->slots & (h->slots - 1)) != 0
+			|| length < sizeof(header) + h->slots * sizeof(uint64_t)) {
+			close();
+			return false;
+		}
+		if (h->max_cells > local_region::max_cells) {
+			close();
+			return false;
+		}
+		slots = reinterpret_cast<const uint64_t*>(h + 1);
+		mask = h->slots - 1;
+		cells = h->max_cells;
+		return true;
+	}
+
+	void close() {
+		if (map) munmap(map, length);
+		map = nullptr;
+		slots = nullptr;
+	}
+
+	bool is_open() const { return map != nullptr; }
+	int max_cells() const { return cells; }
+
+	static uint64_t slot_of(uint64_t key) { return (key * 0x9E3779B97F4A7C15ull) >> 20; }
+	static uint64_t pack(uint64_t key, int black, int white) { return key | (uint64_t(black) << 56) | (uint64_t(white) << 60); }
+
+	/**
+	 * the solo moves of a canonical key, false if the key is not in the table
+	 */
+	bool probe(uint64_t key, int& black, int& white) const {
+		if (!slots || key == 0) return false;
+		for (uint64_t i = slot_of(key) & mask; slots[i]; i = (i + 1) & mask) {
+			if ((slots[i] & ((uint64_t(1) << 56) - 1)) == key) {
+				black = (slots[i] >> 56) & 15;
+				white = (slots[i] >> 60) & 15;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * split the empty points into regions and sum the solo moves of both sides, and count the shared regions,
+	 * where both sides can play and their moves interact, so the sums are exact only without shared regions
+	 * false if any region is not in the table, e.g., it is too large, or a stone around it
+	 * belongs to a block whose liberties are all in the region but which touches it at several points
+	 */
+	bool estimate(const position& pos, int& black, int& white, int& shared) const {
+		black = white = shared = 0;
+		if (!is_open()) return false;
+		uint8_t seen[position::cells + 1] = {};
+		for (int i = 0; i < position::cells; i++) {
+			if (seen[i] || pos.at(i) != board::empty) continue;
+			int region[position::cells], n = 0;
+			region[n++] = i;
+			seen[i] = 1;
+			for (int k = 0; k < n; k++) {
+				for (int d = 0; d < 4; d++) {
+					int q = position::near(region[k], d);
+					if (!seen[q] && pos.at(q) == board::empty) {
+						if (n == cells) return false;
+						seen[q] = 1;
+						region[n++] = q;
+					}
+				}
+			}
+
+			local_region local;
+			int ring[position::cells], num_ring = 0;
+			for (int k = 0; k < n; k++) {
+				board::point p(region[k]);
+				local.add(p.x, p.y, local_region::empty);
+				for (int d = 0; d < 4; d++) {
+					int q = position::near(region[k], d);
+					if (pos.at(q) == board::empty || std::find(ring, ring + num_ring, q) != ring + num_ring) continue;
+					if (q != position::edge) ring[num_ring++] = q;
+					int s = around(pos, q, region, n);
+					if (s < 0) return false;
+					int x = p.x + (d == 1 ? -1 : d == 2 ? 1 : 0), y = p.y + (d == 0 ? -1 : d == 3 ? 1 : 0);
+					local.add(x, y, s);
+				}
+			}
+			int b, w;
+			if (!probe(local.canonical_key(), b, w)) return false;
+			black += b;
+			white += w;
+			shared += b && w;
+		}
+		return true;
+	}
+
+private:
+	/**
+	 * the state of point q around a region, or -1 if it cannot be described locally
+	 */
+	static int around(const position& pos, int q, const int* region, int n) {
+		unsigned who = pos.at(q);
+		if (who != board::black && who != board::white) return local_region::edge;
+		int block = pos.block(q), inside = 0, touch = 0;
+		for (int k = 0; k < n; k++) {
+			bool next_to = false;
+			for (int d = 0; d < 4; d++) {
+				int s = position::near(region[k], d);
+				if (pos.at(s) == who && pos.block(s) == block) {
+					next_to = true;
+					touch += s != q;
+				}
+			}
+			inside += next_to;
+		}
+		if (pos.liberty(q) > inside) return who == board::black ? local_region::black_alive : local_region::white_alive;
+		if (touch) return -1; // a bounded block must touch the region at only this stone
+		return who == board::black ? local_region::black_bounded : local_region::white_bounded;
+	}
+
+private:
+	void* map;
+	size_t length;
+	const uint64_t* slots;
+	uint64_t mask;
+	int cells;
+};
@@ -0,0 +1,174 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * match.cpp: In-process match of two agent specs, with the colors alternating and SPRT early stopping
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <ctime>
+#include "board.h"
+#include "action.h"
+#include "agent.h"
+#include "episode.h"
+#include "sprt.h"
+
+/**
+ * the agent of a spec, i.e., the type followed by the agent arguments, e.g., "mcts N=12000 c=0.5" or "heuristic",
+ * where the type is mcts (player, by default) or heuristic (heuristic_agent)
+ */
+std::unique_ptr<agent> agent_of(const std::string& spec, const std::string& args) {
+	std::string type = spec.substr(0, spec.find(' '));
+	std::string rest = spec.find(' ') != std::string::npos ? spec.substr(spec.find(' ') + 1) : "";
+	if (type.find('=') != std::string::npos) type = "mcts", rest = spec;
+	if (type == "mcts" || type == "player") return std::unique_ptr<agent>(new player(rest + " " + args));
+	if (type == "heuristic") return std::unique_ptr<agent>(new heuristic_agent(rest + " " + args));
+	throw std::invalid_argument("unknown agent type: " + type);
+}
+
+int main(int argc, const char* argv[]) {
+	std::cout << "HollowNoGo-Match: ";
+	std::copy(argv, argv + argc, std::ostream_iterator<const char*>(std::cout, " "));
+	std::cout << std::endl << std::endl;
+
+	std::string first_spec = "mcts", second_spec = "heuristic", save_path;
+	size_t total = 10000, tables = 1, block = 100;
+	double elo0 = 0, elo1 = 10, alpha = 0.05, beta = 0.05;
+	unsigned seed = time(NULL);
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		auto match_arg = [&](std::string flag) -> bool {
+			auto it = arg.find_first_not_of('-');
+			return arg.find(flag, it) == it;
+		};
+		auto next_opt = [&]() -> std::string {
+			auto it = arg.find('=') + 1;
+			return it ? arg.substr(it) : argv[++i];
+		};
+		if (match_arg("first")) {
+			first_spec = next_opt();
+		} else if (match_arg("second")) {
+			second_spec = next_opt();
+		} else if (match_arg("total")) {
+			total = std::stoull(next_opt());
+		} else if (match_arg("games")) {
+			tables = std::stoull(next_opt());
+		} else if (match_arg("block")) {
+			block = std::stoull(next_opt());
+		} else if (match_arg("elo0")) {
+			elo0 = std::stod(next_opt());
+		} else if (match_arg("elo1")) {
+			elo1 = std::stod(next_opt());
+		} else if (match_arg("alpha")) {
+			alpha = std::stod(next_opt());
+		} else if (match_arg("beta")) {
+			beta = std::stod(next_opt());
+		} else if (match_arg("seed")) {
+			seed = std::stoul(next_opt());
+		} else if (match_arg("save")) {
+			save_path = next_opt();
+		}
+	}
+
+	// each table is a thread with both agents in both colors, the search threads are split evenly among the tables
+	std::vector<int> cpus = cpu_set_of();
+	tables = std::max<size_t>(1, std::min(tables, total));
+	size_t share = std::max<size_t>(1, cpus.size() / tables);
+
+	sprt test(elo0, elo1, alpha, beta);
+	std::mutex mutex;
+	std::condition_variable done;
+	std::vector<std::unique_ptr<episode>> results(total);
+	size_t next = 0;
+	bool stop = false;
+
+	// game g is played by first as black if g is even, with the seeds seed + 2g and seed + 2g + 1
+	auto table = [&](size_t t) {
+		std::string slice = "cpus=";
+		for (size_t k = 0; k < share; k++) slice += (k ? "," : "") + std::to_string(cpus[(t * share + k) % cpus.size()]);
+		std::string common = "threads=" + std::to_string(share) + " " + slice + " ";
+		std::unique_ptr<agent> first[] = {
+			agent_of(first_spec, common + "name=first role=black"), agent_of(first_spec, common + "name=first role=white") };
+		std::unique_ptr<agent> second[] = {
+			agent_of(second_spec, common + "name=second role=black"), agent_of(second_spec, common + "name=second role=white") };
+		while (true) {
+			size_t g;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (stop || next == total) break;
+				g = next++;
+			}
+			agent& black = g % 2 == 0 ? *first[0] : *second[0];
+			agent& white = g % 2 == 0 ? *second[1] : *first[1];
+			black.notify("seed=" + std::to_string(seed + 2 * g));
+			white.notify("seed=" + std::to_string(seed + 2 * g + 1));
+			black.open_episode("~:" + white.name());
+			white.open_episode(black.name() + ":~");
+
+			std::unique_ptr<episode> game(new episode());
+			game->open_episode(black.name() + ":" + white.name());
+			while (true) {
+				agent& who = game->take_turns(black, white);
+				action move = who.take_action(game->state(), 0);
+				if (game->apply_action(move) != true) break;
+				if (who.check_for_win(game->state())) break;
+			}
+			agent& win = game->last_turns(black, white);
+			game->close_episode(win.name());
+			black.close_episode(win.name());
+			white.close_episode(win.name());
+
+			std::lock_guard<std::mutex> lock(mutex);
+			results[g] = std::move(game);
+			done.notify_one();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < tables; t++) threads.emplace_back(table, t);
+
+	// the results are tested in game order, so the decision does not depend on the number of tables
+	std::ofstream out;
+	if (save_path.size()) out.open(save_path, std::ios::out | std::ios::trunc);
+	auto report = [&]() {
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << test.games() << "\t" << "first = " << test.won() << "-" << test.lost() << " (" << test.score() * 100 << "%), "
+		          << "elo = " << std::showpos << test.elo() << std::noshowpos << " +- " << test.elo_error() << ", "
+		          << std::setprecision(2) << "llr = " << test.llr() << " [" << test.lower_bound() << ", " << test.upper_bound() << "]"
+		          << std::endl;
+	};
+	sprt::result decision = sprt::undecided;
+	for (size_t g = 0; g < total && decision == sprt::undecided; g++) {
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&]() { return results[g] != nullptr; });
+		std::unique_ptr<episode> game = std::move(results[g]);
+		lock.unlock();
+
+		bool first_black = g % 2 == 0, black_won = game->step() % 2 == 1;
+		test.add(first_black == black_won);
+		if (out.is_open()) out << *game << std::endl;
+		decision = test.decision();
+		if (test.games() % block == 0 || decision != sprt::undecided) report();
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	for (auto& t : threads) t.join();
+
+	if (test.games() % block != 0 && decision == sprt::undecided) report();
+	std::cout << (decision == sprt::accept_h1 ? "H1 accepted: " : decision == sprt::accept_h0 ? "H0 accepted: " : "no decision: ")
+	          << "elo0 = " << elo0 << ", elo1 = " << elo1 << ", alpha = " << alpha << ", beta = " << beta << std::endl;
+	return 0;
+}
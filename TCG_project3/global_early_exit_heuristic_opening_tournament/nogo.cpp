@@ -11,20 +11,402 @@
 #include <fstream>
 #include <iterator>
 #include <string>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <ctime>
+#include <regex>
+#include <csignal>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <ext/stdio_filebuf.h>
 #include "board.h"
 #include "action.h"
 #include "agent.h"
 #include "episode.h"
 #include "statistics.h"
+#include "book.h"
+
+/**
+ * play the remaining games of stats on concurrent tables, each table is a thread with its own players,
+ * the game g is played with seeds seed + 2g and seed + 2g + 1, so a game does not depend on its table
+ *
+ * the search threads of the players are split evenly among the tables (threads=K in the player arguments overrides it),
+ * and the finished games are added to stats in game order
+ */
+void run_tournament(statistics& stats, size_t tables, unsigned seed, const std::string& black_args, const std::string& white_args) {
+	std::vector<int> cpus = cpu_set_of();
+	size_t share = std::max<size_t>(1, cpus.size() / tables);
+	size_t first = stats.step(), total = first + stats.remaining();
+
+	std::mutex mutex;
+	std::condition_variable done;
+	std::vector<std::unique_ptr<episode>> results(total - first);
+	size_t next = first;
+
+	auto table = [&](size_t t) {
+		std::string slice = "cpus=";
+		for (size_t k = 0; k < share; k++) slice += (k ? "," : "") + std::to_string(cpus[(t * share + k) % cpus.size()]);
+		std::string common = " threads=" + std::to_string(share) + " " + slice + " ";
+		player black("name=black" + common + black_args + " role=black");
+		player white("name=white" + common + white_args + " role=white");
+		while (true) {
+			size_t g;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (next == total) break;
+				g = next++;
+			}
+			black.notify("seed=" + std::to_string(seed + 2 * g));
+			white.notify("seed=" + std::to_string(seed + 2 * g + 1));
+			black.notify("game=" + std::to_string(g + 1));
+			white.notify("game=" + std::to_string(g + 1));
+			black.open_episode("~:" + white.name());
+			white.open_episode(black.name() + ":~");
+
+			std::unique_ptr<episode> game(new episode());
+			game->open_episode(black.name() + ":" + white.name());
+			while (true) {
+				agent& who = game->take_turns(black, white);
+				action move = who.take_action(game->state(), 0);
+				if (game->apply_action(move) != true) break;
+				if (who.check_for_win(game->state())) break;
+			}
+			agent& win = game->last_turns(black, white);
+			game->close_episode(win.name());
+			black.close_episode(win.name());
+			white.close_episode(win.name());
+
+			std::lock_guard<std::mutex> lock(mutex);
+			results[g - first] = std::move(game);
+			done.notify_one();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < std::min(tables, total - first); t++) threads.emplace_back(table, t);
+	for (size_t g = first; g < total; g++) {
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&]() { return results[g - first] != nullptr; });
+		std::unique_ptr<episode> game = std::move(results[g - first]);
+		lock.unlock();
+		stats.append_episode(*game);
+	}
+	for (auto& t : threads) t.join();
+}
+
+/**
+ * search every position of the input, i.e., a line of moves in the action format (e.g., ;B[ee];W[df]),
+ * on concurrent jobs, and write one line per position in the input order:
+ *   index, moves, best move, its win rate, and the root visits of all moves, separated by tabs, e.g.,
+ *   3	;B[ee];W[df]	D4	0.5813	D4:5102 E6:2048 C5:730 ...
+ * the move of a position without legal moves is PASS, and an illegal line is reported as "illegal"
+ */
+void run_analysis(std::istream& in, std::ostream& out, size_t jobs, unsigned seed, const std::string& args) {
+	std::vector<std::string> lines;
+	for (std::string line; std::getline(in, line); ) {
+		if (line.size() && line.back() == '\r') line.pop_back();
+		if (line.size()) lines.push_back(line);
+	}
+	std::vector<int> cpus = cpu_set_of();
+	jobs = std::max<size_t>(1, std::min(jobs ? jobs : cpus.size(), lines.size()));
+	size_t share = std::max<size_t>(1, cpus.size() / jobs);
+
+	std::mutex mutex;
+	std::condition_variable done;
+	std::vector<std::unique_ptr<std::string>> results(lines.size());
+	size_t next = 0;
+
+	auto job = [&](size_t t) {
+		std::string slice = "cpus=";
+		for (size_t k = 0; k < share; k++) slice += (k ? "," : "") + std::to_string(cpus[(t * share + k) % cpus.size()]);
+		std::string common = " threads=" + std::to_string(share) + " " + slice + " ";
+		player black("name=black" + common + args + " role=black");
+		player white("name=white" + common + args + " role=white");
+		std::regex token(action::place::syntax());
+		while (true) {
+			size_t k;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (next == lines.size()) break;
+				k = next++;
+			}
+			std::stringstream result;
+			result << k << "\t";
+			board state;
+			bool legal = true;
+			const std::string& line = lines[k];
+			for (auto it = std::sregex_iterator(line.begin(), line.end(), token); it != std::sregex_iterator(); it++) {
+				std::stringstream ss(it->str());
+				action::place move;
+				ss >> move;
+				result << move;
+				legal &= move.apply(state) == board::legal;
+			}
+			if (!legal) {
+				result << "\tillegal";
+			} else {
+				player& who = state.info().who_take_turns == board::black ? black : white;
+				who.notify("seed=" + std::to_string(seed + k));
+				action move = who.take_action(state, 0);
+				auto root = who.last_search().root;
+				std::sort(root.begin(), root.end(), [](const search_trace::child& a, const search_trace::child& b) { return a.visits > b.visits; });
+				int best = move.type() == action::place::type ? action::place(move).position().i : -1;
+				float value = 0;
+				for (auto& c : root) if (c.move == best && c.visits) value = float(c.wins) / c.visits;
+				if (best >= 0 && root.empty()) value = 1; // solved by df-pn
+				result << "\t" << std::string(board::point(best)) << "\t" << std::fixed << std::setprecision(4) << value << "\t";
+				for (size_t i = 0; i < root.size(); i++) result << (i ? " " : "") << std::string(board::point(root[i].move)) << ":" << root[i].visits;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			results[k].reset(new std::string(result.str()));
+			done.notify_one();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < jobs; t++) threads.emplace_back(job, t);
+	for (size_t k = 0; k < lines.size(); k++) {
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&]() { return results[k] != nullptr; });
+		std::unique_ptr<std::string> result = std::move(results[k]);
+		lock.unlock();
+		out << *result << std::endl;
+	}
+	for (auto& t : threads) t.join();
+}
+
+/**
+ * run a GTP session over in and out with its own players, until quit or the end of in
+ * the games of the session are added to stats, and the book (read only) may be shared by concurrent sessions
+ */
+void run_shell(std::istream& in, std::ostream& out, statistics& stats, const opening_book& book,
+               const std::string& black_args, const std::string& white_args, const std::string& name, const std::string& version) {
+	player black("name=black " + black_args + " role=black");
+	heuristic_agent black_opening("name=black " + black_args + " role=black");
+	player white("name=white " + white_args + " role=white");
+	heuristic_agent white_opening("name=white " + white_args + " role=white");
+
+	int steps = 0;
+	std::string search_line[2] = { "no search", "no search" }; // the last search of black and white, see search_stats
+	int last_color = 0;
+	// std::vector<int> all_moves(72, -1);
+	for (std::string command; std::getline(in, command); ) {
+		if (command.back() == '\r') command.pop_back();
+		if (command.empty()) continue;
+
+		std::vector<std::string> args;
+		std::istringstream iss(command);
+		for (std::string s; getline(iss, s, ' '); args.push_back(s));
+
+		std::string reply;
+		if (args[0] == "play" || args[0] == "genmove") { // play a move, or generate a move and play
+			if (!stats.is_episode_ongoing()) { // should open an episode
+				steps = 0;
+				/*
+				for (int i = 0; i < 72; ++i) {
+					all_moves[i] = -1;
+				}
+				*/
+				black.open_episode("~:" + white.name());
+				white.open_episode(black.name() + ":~");
+				stats.open_episode(black.name() + ":" + white.name());
+			}
+
+			episode& game = stats.back();
+			agent& who = game.take_turns(black, white);
+			if (who.role()[0] != std::tolower(args[1][0])) { // player mismatch?!
+				out << "= " << "resign" << std::endl << std::endl;
+				// show the error message and terminate the shell
+				std::cerr << "player color " << args[1] << " mismatch!" << std::endl;
+				std::cerr << "current state, "
+				          << who.role() << " to play: " << std::endl << game.state();
+				break;
+			}
+			if (args[0] == "play") { // play a move
+				steps++;
+				std::string types = "?bw"; // black == 1, white == 2
+				action::place move(args[2], types.find(who.role()[0]));
+
+				// int pos = move.position().i;
+				// all_moves[steps] = pos;
+
+				if (game.apply_action(move) != true) { // remote plays an illegal move?!
+					out << "= " << "resign" << std::endl << std::endl;
+					// show the error message and terminate the shell
+					std::cerr << who.role() << " plays an illegal action!" << std::endl;
+					const char* reason[] = {
+						"legal",
+						"illegal_turn",
+						"illegal_pass",
+						"illegal_out_of_range",
+						"illegal_not_empty",
+						"illegal_suicide",
+						"illegal_take",
+						"unknown",
+					};
+					std::cerr << "current state: " << std::endl << game.state();
+					int code = move.apply(game.state());
+					std::cerr << "action: " << args[1] << " " << args[2] << std::endl;
+					std::cerr << "reason: " << reason[std::min(-code, 7)] << std::endl;
+					break;
+				}
+			} else if (args[0] == "genmove") { // generate a move and play
+				steps++;
+				action::place move;
+				int book_move;
+
+				last_color = who.role() == "white";
+				if (book.probe(game.state(), book_move)) { // no search for the book moves
+					move = action::place(book_move, game.state().info().who_take_turns);
+					search_line[last_color] = "book";
+				} else if (steps <= 10) {
+					if (steps % 2 == 0) { // white
+						move = white_opening.take_action(game.state(), steps);
+					} else {         // black
+						move = black_opening.take_action(game.state(), steps);
+					}
+					search_line[last_color] = "opening";
+
+				} else {
+					move = who.take_action(game.state(), steps);
+					search_line[last_color] = (last_color ? white : black).search_stats();
+				}
+
+				// int pos = move.position().i;
+				// all_moves[steps] = pos;
+
+				if (game.apply_action(move) == true) {
+					reply = move.position();
+				} else { // I have no legal move to play
+					reply = "resign";
+				}
+			}
+
+		} else if (args[0] == "clear_board" || args[0] == "quit") { // reset game, or quit
+			if (stats.is_episode_ongoing()) { // should close an opened episode
+				agent& win = stats.back().last_turns(black, white);
+				stats.close_episode(win.name());
+				black.close_episode(win.name());
+				white.close_episode(win.name());
+			}
+			if (args[0] == "quit") break; // quit GTP shell
+
+		} else if (args[0] == "showboard") { // print the board
+			std::stringstream buf;
+			buf << (stats.is_episode_ongoing() ? stats.back().state() : board());
+			reply = "\n" + buf.str();
+			reply.pop_back(); // remove a new line
+
+		} else if (args[0] == "boardsize") { // set the board size
+			size_t size = std::stoul(args[1]);
+			if (size != board::size_x || size != board::size_y) {
+				std::cerr << "board size mismatch: " << args[1] << std::endl;
+			}
+			if (size > board::size_x || size > board::size_y) break;
+
+		} else if (args[0] == "search_stats") { // report the counters of the last search, of the last genmove by default
+			int color = args.size() > 1 ? std::tolower(args[1][0]) == 'w' : last_color;
+			reply = search_line[color];
+
+		} else if (args[0] == "name") { // report the name of the program
+			reply = name;
+		} else if (args[0] == "version") { // report the version number of the program
+			reply = version;
+		} else if (args[0] == "protocol_version") { // report GTP protocol version
+			reply = "2";
+		} else if (args[0] == "list_commands") { // print supported commands
+			reply = "play\n" "genmove\n" "clear_board\n" "showboard\n" "boardsize\n"
+			        "name\n" "version\n" "protocol_version\n" "list_commands\n" "search_stats\n" "quit\n";
+		} else {
+			reply = "unknown command";
+		}
+
+		out << "= " << reply << std::endl << std::endl;
+	}
+}
+
+/**
+ * serve GTP sessions on a TCP port, each connection is a session of run_shell on its own thread,
+ * and the searches of all sessions share the pool of search threads (pool=1 in the player arguments),
+ * so the number of search threads stays fixed however many sessions are open
+ *
+ * the games of a session are appended to save_path when the session ends
+ */
+int run_server(int port, const opening_book& book, const std::string& black_args, const std::string& white_args,
+               const std::string& name, const std::string& version, const std::string& save_path) {
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	int reuse = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (listener < 0 || bind(listener, (sockaddr*) &addr, sizeof(addr)) != 0 || listen(listener, 64) != 0) {
+		std::cerr << "cannot listen on port " << port << std::endl;
+		return 1;
+	}
+	signal(SIGPIPE, SIG_IGN); // a closed connection ends its session instead of the server
+	std::cerr << "serving GTP on port " << port << " with " << search_pool::shared().size() << " search threads" << std::endl;
+
+	// the sessions use the arguments and the book of this frame, so they are joined before it returns
+	std::mutex mutex; // guards the save file and the closed sessions
+	std::map<size_t, std::thread> sessions;
+	std::vector<size_t> closed;
+	auto join_closed = [&]() {
+		std::vector<size_t> ids;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			ids.swap(closed);
+		}
+		for (size_t id : ids) {
+			sessions[id].join();
+			sessions.erase(id);
+		}
+	};
+	for (size_t id = 0; ; id++) {
+		int fd = accept(listener, nullptr, nullptr);
+		if (fd < 0 && errno == EINTR) continue;
+		if (fd < 0) break;
+		join_closed();
+		sessions[id] = std::thread([&, fd, id]() {
+			std::cerr << "session " << id << " opened" << std::endl;
+			statistics stats(-1);
+			{
+				__gnu_cxx::stdio_filebuf<char> inbuf(fd, std::ios::in), outbuf(dup(fd), std::ios::out);
+				std::istream in(&inbuf);
+				std::ostream out(&outbuf);
+				run_shell(in, out, stats, book, black_args + " pool=1", white_args + " pool=1", name, version);
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			if (save_path.size() && stats.step()) {
+				std::ofstream out(save_path, std::ios::out | std::ios::app);
+				out << stats;
+			}
+			std::cerr << "session " << id << " closed after " << stats.step() << " games" << std::endl;
+			closed.push_back(id);
+		});
+	}
+	close(listener);
+	join_closed();
+	std::cerr << "cannot accept connections on port " << port << ", waiting for " << sessions.size() << " sessions" << std::endl;
+	for (auto& session : sessions) session.second.join();
+	return 1;
+}
 
 int main(int argc, const char* argv[]) {
 	std::cout << "HollowNoGo-Demo: ";
 	std::copy(argv, argv + argc, std::ostream_iterator<const char*>(std::cout, " "));
 	std::cout << std::endl << std::endl;
 
-	size_t total = 1000, block = 0, limit = 0;
-	std::string black_args, white_args;
-	std::string load_path, save_path;
+	size_t total = 1000, block = 0, limit = 0, games = 1, jobs = 0, pool_size = 0;
+	int server_port = 0;
+	unsigned seed = time(NULL);
+	std::string black_args, white_args, search_args;
+	std::string load_path, save_path, book_path, analyze_path, output_path;
 	std::string name = "TCG-HollowNoGo-Demo", version = "2022"; // for GTP shell
 	bool shell = false;
 	for (int i = 1; i < argc; i++) {
@@ -51,15 +433,45 @@ int main(int argc, const char* argv[]) {
 			load_path = next_opt();
 		} else if (match_arg("save")) {
 			save_path = next_opt();
+		} else if (match_arg("book")) {
+			book_path = next_opt();
 		} else if (match_arg("name")) {
 			name = next_opt();
 		} else if (match_arg("version")) {
 			version = next_opt();
+		} else if (match_arg("games")) {
+			games = std::stoull(next_opt());
+		} else if (match_arg("analyze")) {
+			analyze_path = next_opt();
+		} else if (match_arg("output")) {
+			output_path = next_opt();
+		} else if (match_arg("search")) {
+			search_args = next_opt();
+		} else if (match_arg("jobs")) {
+			jobs = std::stoull(next_opt());
+		} else if (match_arg("seed")) {
+			seed = std::stoul(next_opt());
 		} else if (match_arg("shell")) {
 			shell = true;
+		} else if (match_arg("server")) {
+			server_port = std::stoi(next_opt());
+		} else if (match_arg("pool")) {
+			pool_size = std::stoull(next_opt());
 		}
 	}
 
+	if (analyze_path.size()) { // search the positions and write the results, no games are played
+		std::ifstream in(analyze_path);
+		if (!in.is_open()) {
+			std::cerr << "cannot open positions: " << analyze_path << std::endl;
+			return 1;
+		}
+		std::ofstream file;
+		if (output_path.size()) file.open(output_path, std::ios::out | std::ios::trunc);
+		run_analysis(in, output_path.size() ? file : std::cout, jobs, seed, search_args);
+		return 0;
+	}
+
 	statistics stats(total, block, limit);
 
 	if (load_path.size()) {
@@ -69,12 +481,34 @@ int main(int argc, const char* argv[]) {
 		if (stats.is_finished()) stats.summary();
 	}
 
-	player black("name=black " + black_args + " role=black");
-	heuristic_agent black_opening("name=black " + black_args + " role=black");
-	player white("name=white " + white_args + " role=white");
-	heuristic_agent white_opening("name=white " + white_args + " role=white");
+	opening_book book;
+	if (book_path.size() && !book.open(book_path)) {
+		std::cerr << "cannot open opening book: " << book_path << std::endl;
+		return 1;
+	}
 
-	if (!shell) { // launch standard local games
+	if (!shell && games > 1) { // launch concurrent local games on the tables
+		run_tournament(stats, games, seed, black_args, white_args);
+		stats.summary();
+		stats.show_interval(stats.step());
+		if (save_path.size()) {
+			std::ofstream out(save_path, std::ios::out | std::ios::trunc);
+			out << stats;
+			out.close();
+		}
+		return 0;
+	}
+
+	if (server_port > 0) { // serve GTP sessions, no local games are played
+		if (pool_size) search_pool::shared(pool_size);
+		return run_server(server_port, book, black_args, white_args, name, version, save_path);
+	}
+
+	if (shell) { // launch GTP shell
+		run_shell(std::cin, std::cout, stats, book, black_args, white_args, name, version);
+	} else { // launch standard local games
+		player black("name=black " + black_args + " role=black");
+		player white("name=white " + white_args + " role=white");
 		while (!stats.is_finished()) {
 //			std::cerr << "======== Game " << stats.step() << " ========" << std::endl;
 			black.open_episode("~:" + white.name());
@@ -95,131 +529,6 @@ int main(int argc, const char* argv[]) {
 			black.close_episode(win.name());
 			white.close_episode(win.name());
 		}
-	} else { // launch GTP shell
-		int steps = 0;
-		// std::vector<int> all_moves(72, -1);
-		for (std::string command; std::getline(std::cin, command); ) {
-			if (command.back() == '\r') command.pop_back();
-			if (command.empty()) continue;
-
-			std::vector<std::string> args;
-			std::istringstream iss(command);
-			for (std::string s; getline(iss, s, ' '); args.push_back(s));
-
-			std::string reply;
-			if (args[0] == "play" || args[0] == "genmove") { // play a move, or generate a move and play
-				if (!stats.is_episode_ongoing()) { // should open an episode
-					steps = 0;
-					/*
-					for (int i = 0; i < 72; ++i) {
-						all_moves[i] = -1;
-					}
-					*/
-					black.open_episode("~:" + white.name());
-					white.open_episode(black.name() + ":~");
-					stats.open_episode(black.name() + ":" + white.name());
-				}
-
-				episode& game = stats.back();
-				agent& who = game.take_turns(black, white);
-				if (who.role()[0] != std::tolower(args[1][0])) { // player mismatch?!
-					std::cout << "= " << "resign" << std::endl << std::endl;
-					// show the error message and terminate the shell
-					std::cerr << "player color " << args[1] << " mismatch!" << std::endl;
-					std::cerr << "current state, "
-					          << who.role() << " to play: " << std::endl << game.state();
-					break;
-				}
-				if (args[0] == "play") { // play a move
-					steps++;
-					std::string types = "?bw"; // black == 1, white == 2
-					action::place move(args[2], types.find(who.role()[0]));
-
-					// int pos = move.position().i;
-					// all_moves[steps] = pos;
-
-					if (game.apply_action(move) != true) { // remote plays an illegal move?!
-						std::cout << "= " << "resign" << std::endl << std::endl;
-						// show the error message and terminate the shell
-						std::cerr << who.role() << " plays an illegal action!" << std::endl;
-						const char* reason[] = {
-							"legal",
-							"illegal_turn",
-							"illegal_pass",
-							"illegal_out_of_range",
-							"illegal_not_empty",
-							"illegal_suicide",
-							"illegal_take",
-							"unknown",
-						};
-						std::cerr << "current state: " << std::endl << game.state();
-						int code = move.apply(game.state());
-						std::cerr << "action: " << args[1] << " " << args[2] << std::endl;
-						std::cerr << "reason: " << reason[std::min(-code, 7)] << std::endl;
-						break;
-					}
-				} else if (args[0] == "genmove") { // generate a move and play
-					steps++;
-					action::place move;
-					
-					if (steps <= 10) {
-						if (steps % 2 == 0) { // white
-							move = white_opening.take_action(game.state(), steps);
-						} else {         // black
-							move = black_opening.take_action(game.state(), steps);
-						}
-
-					} else {
-						move = who.take_action(game.state(), steps);
-					}
-
-					// int pos = move.position().i;
-					// all_moves[steps] = pos;
-
-					if (game.apply_action(move) == true) {
-						reply = move.position();
-					} else { // I have no legal move to play
-						reply = "resign";
-					}
-				}
-
-			} else if (args[0] == "clear_board" || args[0] == "quit") { // reset game, or quit
-				if (stats.is_episode_ongoing()) { // should close an opened episode
-					agent& win = stats.back().last_turns(black, white);
-					stats.close_episode(win.name());
-					black.close_episode(win.name());
-					white.close_episode(win.name());
-				}
-				if (args[0] == "quit") break; // quit GTP shell
-
-			} else if (args[0] == "showboard") { // print the board
-				std::stringstream buf;
-				buf << (stats.is_episode_ongoing() ? stats.back().state() : board());
-				reply = "\n" + buf.str();
-				reply.pop_back(); // remove a new line
-
-			} else if (args[0] == "boardsize") { // set the board size
-				size_t size = std::stoul(args[1]);
-				if (size != board::size_x || size != board::size_y) {
-					std::cerr << "board size mismatch: " << args[1] << std::endl;
-				}
-				if (size > board::size_x || size > board::size_y) break;
-
-			} else if (args[0] == "name") { // report the name of the program
-				reply = name;
-			} else if (args[0] == "version") { // report the version number of the program
-				reply = version;
-			} else if (args[0] == "protocol_version") { // report GTP protocol version
-				reply = "2";
-			} else if (args[0] == "list_commands") { // print supported commands
-				reply = "play\n" "genmove\n" "clear_board\n" "showboard\n" "boardsize\n"
-				        "name\n" "version\n" "protocol_version\n" "list_commands\n" "quit\n";
-			} else {
-				reply = "unknown command";
-			}
-
-			std::cout << "= " << reply << std::endl << std::endl;
-		}
 	}
 
 	if (save_path.size()) {
@@ -0,0 +1,59 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * pattern.h: Precomputed features of the 3x3 neighborhood patterns
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include "board.h"
+
+/**
+ * the local features of a point, decided only by its 3x3 pattern code (see position::pattern)
+ * every pattern and color is looked up from one precomputed table, for example
+ *   pattern::feature f = pattern::of(code, board::black);
+ *   f.eye(), f.liberty(), f.atari(), f.side(), f.corner()
+ */
+class pattern {
+public:
+	enum { codes = 1 << 16 };
+
+	struct feature {
+		uint16_t bits;
+		bool eye() const { return bits & 1u; }            // all 4 sides are own or hollow
+		bool atari() const { return bits & 2u; }          // 3 sides are opponent or hollow, 1 side is empty
+		int liberty() const { return (bits >> 2) & 7u; }  // empty sides
+		int side() const { return (bits >> 5) & 7u; }     // own stones at the sides
+		int corner() const { return (bits >> 8) & 7u; }   // own stones at the corners
+	};
+
+	static feature of(uint16_t code, unsigned who) { return table()[who - 1][code]; }
+
+private:
+	typedef std::array<std::array<feature, codes>, 2> features;
+	static const features& table() { static features t; return t; }
+	static __attribute__((constructor)) void init_table() {
+		features& t = const_cast<features&>(table());
+		for (unsigned code = 0; code < codes; code++) {
+			unsigned near[8];
+			for (int k = 0; k < 8; k++) near[k] = (code >> (2 * k)) & 3u;
+			for (unsigned who = board::black; who <= board::white; who++) {
+				unsigned opp = 3u - who;
+				unsigned eye = 1, closed = 0, liberty = 0, side = 0, corner = 0;
+				for (int k = 0; k < 4; k++) {
+					eye &= near[k] == who || near[k] == board::hollow;
+					closed += near[k] == opp || near[k] == board::hollow;
+					liberty += near[k] == board::empty;
+					side += near[k] == who;
+					corner += near[4 + k] == who;
+				}
+				unsigned atari = closed == 3 && liberty == 1;
+				t[who - 1][code].bits = eye | (atari << 1) | (liberty << 2) | (side << 5) | (corner << 8);
+			}
+		}
+	}
+};
@@ -0,0 +1,153 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * playout.h: Pattern-weighted playout policy
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <array>
+#include <random>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <stdexcept>
+#include "board.h"
+#include "position.h"
+#include "pattern.h"
+
+/**
+ * the weight of playing at a point, looked up by the 3x3 pattern code seen by the player to move
+ * codes are stored for black to move, the codes of white are converted by swapping the colors
+ *
+ * the default weights follow the local terms of heuristic::action_value,
+ * a weight file overrides them with lines of "code weight", e.g.,
+ *   # code weight
+ *   0 64
+ *   21845 1
+ */
+class playout_policy {
+public:
+	enum { max_weight = 65535 };
+
+	playout_policy() {
+		for (unsigned code = 0; code < pattern::codes; code++) {
+			pattern::feature self = pattern::of(code, board::black), oppo = pattern::of(code, board::white);
+			float score = - 16 * self.eye() + 8 * self.liberty() + 24 * self.atari()
+			              + 8 * self.corner() + oppo.corner() + oppo.side();
+			weights[code] = clamp(std::lround(64 * std::exp(score / 32)));
+		}
+	}
+
+	void load(const std::string& path) {
+		std::ifstream in(path);
+		if (!in.is_open()) throw std::invalid_argument("cannot open playout weights: " + path);
+		for (std::string line; std::getline(in, line); ) {
+			if (line.empty() || line[0] == '#') continue;
+			std::stringstream ss(line);
+			unsigned code; double weight;
+			if (!(ss >> code >> weight) || code >= pattern::codes)
+				throw std::invalid_argument("invalid playout weight: " + line);
+			weights[code] = clamp(std::lround(weight));
+		}
+	}
+
+	unsigned weight(uint16_t code, unsigned who) const {
+		return weights[who == board::black ? code : swap_colors(code)];
+	}
+
+private:
+	static uint16_t swap_colors(uint16_t code) {
+		unsigned lo = code & 0x5555u, hi = (code >> 1) & 0x5555u;
+		unsigned one_of = lo ^ hi; // digits which are black or white
+		return code ^ (one_of | (one_of << 1));
+	}
+	static uint16_t clamp(long w) {
+		return std::min<long>(std::max<long>(w, 1), max_weight); // a legal move is never unreachable
+	}
+
+	std::array<uint16_t, pattern::codes> weights;
+};
+
+/**
+ * sample moves in proportion to the playout weights
+ *
+ * the weights of both sides are kept in two Fenwick trees, so sampling and updating a point cost O(log n)
+ * after each move only the points whose legality or pattern changed are updated
+ */
+class playout_sampler {
+public:
+	playout_sampler(const position& pos, const playout_policy& policy) : policy(policy) {
+		for (unsigned who = board::black; who <= board::white; who++) {
+			tree& t = trees[who - 1];
+			t.value.fill(0);
+			t.sum.fill(0);
+			for (int i = 0; i < position::cells; i++)
+				if (pos.legal(i, who)) t.set(i, policy.weight(pos.pattern(i), who));
+		}
+	}
+
+	unsigned total(unsigned who) const { return trees[who - 1].total(); }
+
+	/**
+	 * pick a legal move of who, there should be at least one
+	 */
+	template<typename random>
+	int sample(unsigned who, random& engine) const {
+		const tree& t = trees[who - 1];
+		std::uniform_int_distribution<unsigned> dist(0, t.total() - 1);
+		return t.find(dist(engine));
+	}
+
+	/**
+	 * place a stone at i, and refresh the weights that changed
+	 */
+	void place(position& pos, int i) {
+		position::mask before[2] = { pos.legal_of(board::black), pos.legal_of(board::white) };
+		pos.place(i);
+		for (unsigned who = board::black; who <= board::white; who++) {
+			position::mask dirty = before[who - 1] ^ pos.legal_of(who);
+			for (int k = 0; k < 4; k++) { // the patterns around i
+				if (position::near(i, k) != position::edge) dirty.set(position::near(i, k));
+				if (position::corner(i, k) != position::edge) dirty.set(position::corner(i, k));
+			}
+			tree& t = trees[who - 1];
+			for (size_t p = dirty._Find_first(); p < position::cells; p = dirty._Find_next(p))
+				t.set(p, pos.legal(p, who) ? policy.weight(pos.pattern(p), who) : 0);
+		}
+	}
+
+private:
+	struct tree {
+		std::array<unsigned, position::cells> value;
+		std::array<unsigned, position::cells + 1> sum; // 1-based Fenwick tree
+
+		unsigned total() const {
+			unsigned s = 0;
+			for (int i = position::cells; i > 0; i -= i & -i) s += sum[i];
+			return s;
+		}
+		void set(int i, unsigned w) {
+			unsigned delta = w - value[i];
+			value[i] = w;
+			for (int j = i + 1; j <= position::cells; j += j & -j) sum[j] += delta; // wraps around if w < value
+		}
+		int find(unsigned r) const {
+			int pos = 0, top = 1;
+			while (top * 2 <= position::cells) top *= 2; // the highest power of 2 in range
+			for (int step = top; step; step >>= 1) {
+				if (pos + step <= position::cells && sum[pos + step] <= r) {
+					pos += step;
+					r -= sum[pos];
+				}
+			}
+			return pos; // the 0-based point whose prefix range covers r
+		}
+	};
+
+	const playout_policy& policy;
+	tree trees[2];
+};
@@ -0,0 +1,143 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * pool.h: Work-stealing pool of search threads shared by the searches of a process
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include "affinity.h"
+
+/**
+ * a search is split into tasks (e.g., the trees of the root-parallel MCTS), and a task is run in steps
+ * (e.g., a chunk of simulations), so the searches of all sessions take turns on a fixed number of workers
+ *
+ * every worker keeps a queue of tasks, runs the front one for a step, and puts it back to the end unless it is finished,
+ * so the tasks of a worker share it round-robin; an idle worker steals from the end of the other queues
+ */
+class search_pool {
+public:
+	explicit search_pool(size_t workers) : queues(std::max<size_t>(workers, 1)), pending(0), next(0), stop(false) {
+		for (auto& q : queues) q.reset(new queue());
+		for (size_t w = 0; w < queues.size(); w++) threads.emplace_back(&search_pool::work, this, w);
+	}
+	~search_pool() {
+		{
+			std::lock_guard<std::mutex> lock(idle_mutex);
+			stop = true;
+		}
+		idle.notify_all();
+		for (auto& t : threads) t.join();
+	}
+	search_pool(const search_pool&) = delete;
+	search_pool& operator =(const search_pool&) = delete;
+
+	/**
+	 * the pool of the process, whose size is fixed by the first call (one worker per processor by default)
+	 */
+	static search_pool& shared(size_t workers = 0) {
+		static search_pool pool(workers ? workers : cpu_set_of().size());
+		return pool;
+	}
+
+	size_t size() const { return queues.size(); }
+
+	/**
+	 * run step(id) for every id in [0, tasks) until it returns true, and wait for all of them
+	 * the steps of a task are never run concurrently, but may be run by different workers
+	 */
+	void run(int tasks, const std::function<bool(int)>& step) {
+		latch done(tasks);
+		for (int id = 0; id < tasks; id++) {
+			push(next++ % queues.size(), { &step, id, &done });
+		}
+		done.wait();
+	}
+
+private:
+	struct latch {
+		latch(int count) : count(count) {}
+		void count_down() {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--count == 0) zero.notify_all();
+		}
+		void wait() {
+			std::unique_lock<std::mutex> lock(mutex);
+			zero.wait(lock, [this]() { return count == 0; });
+		}
+		int count;
+		std::mutex mutex;
+		std::condition_variable zero;
+	};
+	struct task {
+		const std::function<bool(int)>* step;
+		int id;
+		latch* done;
+	};
+	struct queue {
+		std::deque<task> tasks;
+		std::mutex mutex;
+	};
+
+	void push(size_t w, const task& t) {
+		{
+			std::lock_guard<std::mutex> lock(idle_mutex);
+			pending++; // counted first, so pending never drops below the queued tasks
+		}
+		{
+			std::lock_guard<std::mutex> lock(queues[w]->mutex);
+			queues[w]->tasks.push_back(t);
+		}
+		idle.notify_one();
+	}
+
+	bool pop(size_t w, task& t) {
+		for (size_t k = 0; k < queues.size(); k++) {
+			queue& q = *queues[(w + k) % queues.size()];
+			std::lock_guard<std::mutex> lock(q.mutex);
+			if (q.tasks.empty()) continue;
+			if (k == 0) { // the own queue, from the front
+				t = q.tasks.front();
+				q.tasks.pop_front();
+			} else { // steal from the end
+				t = q.tasks.back();
+				q.tasks.pop_back();
+			}
+			pending--;
+			return true;
+		}
+		return false;
+	}
+
+	void work(size_t w) {
+		while (true) {
+			task t;
+			if (pop(w, t)) {
+				if ((*t.step)(t.id)) t.done->count_down();
+				else push(w, t);
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(idle_mutex);
+			idle.wait(lock, [this]() { return stop || pending > 0; });
+			if (stop) return;
+		}
+	}
+
+	std::vector<std::unique_ptr<queue>> queues;
+	std::vector<std::thread> threads;
+	std::mutex idle_mutex;
+	std::condition_variable idle;
+	std::atomic<size_t> pending;
+	std::atomic<size_t> next;
+	bool stop;
+};
@@ -0,0 +1,330 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * position.h: Board state with incrementally maintained blocks, liberties and legal moves
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <array>
+#include <algorithm>
+#include "board.h"
+
+/**
+ * a board together with its blocks, liberties and legal moves of both sides
+ *
+ * the points are indexed as board::point, i.e., i == x * size_y + y
+ * the stones of a block form a circular list through next[], and every stone keeps the root of its block,
+ * the liberty count of a block is stored at its root
+ * placing a stone only updates the blocks next to it, and re-tests the points whose legality may change,
+ * so no operation allocates and a copy is a plain memory copy
+ *
+ * every point also keeps the 3x3 pattern code of its 8 neighbors, see pattern()
+ * and the position keeps its Zobrist key, see hash()
+ *
+ * the hollow board is symmetric under the 8 rotations and reflections, so the position also keeps
+ * the Zobrist keys of its 8 symmetric images, and symmetric positions share one canonical key
+ */
+class position {
+public:
+	enum { cells = board::size_x * board::size_y, edge = cells, symmetries = 8 };
+	typedef std::bitset<cells> mask;
+
+public:
+	position(const board& from = board()) : b(from) {
+		for (int i = 0; i < cells; i++) {
+			board::point p(i);
+			cell[i] = from[p.x][p.y];
+		}
+		cell[edge] = board::hollow; // the outside behaves as the hollow points
+		for (int i = 0; i <= edge; i++) root[i] = next[i] = i, libs[i] = 0;
+
+		uint8_t seen[cells + 1] = {};
+		for (int i = 0; i < cells; i++) {
+			if (seen[i] || (cell[i] != board::black && cell[i] != board::white)) continue;
+			// collect the block of i into the list next[]
+			int stack[cells], top = 0, last = i;
+			stack[top++] = i;
+			seen[i] = 1;
+			while (top) {
+				int s = stack[--top];
+				root[s] = i;
+				if (s != i) next[s] = next[last], next[last] = s, last = s;
+				for (int k = 0; k < 4; k++) {
+					int n = near(s, k);
+					if (!seen[n] && cell[n] == cell[i]) seen[n] = 1, stack[top++] = n;
+				}
+			}
+			libs[i] = count_liberty_of(i);
+		}
+		for (int i = 0; i < cells; i++) update_legal(i);
+
+		for (int i = 0; i <= edge; i++) code[i] = 0;
+		for (int i = 0; i < cells; i++)
+			for (int k = 0; k < 8; k++) code[i] |= cell[neighbors()[i][k]] << (2 * k);
+
+		for (int t = 0; t < symmetries; t++) key[t] = 0;
+		for (int i = 0; i < cells; i++) {
+			if (cell[i] != board::black && cell[i] != board::white) continue;
+			for (int t = 0; t < symmetries; t++) key[t] ^= zobrist(symmetric(i, t), cell[i]);
+		}
+	}
+	position(const position&) = default;
+	position& operator =(const position&) = default;
+
+public:
+	const board& state() const { return b; }
+	operator const board&() const { return b; }
+	board::piece_type who_take_turns() const { return b.info().who_take_turns; }
+
+	unsigned at(int i) const { return cell[i]; }
+	bool legal(int i, unsigned who) const { return legal_of(who)[i]; }
+	const mask& legal_of(unsigned who) const { return legal_move[who - 1]; }
+	int count_legal(unsigned who) const { return legal_of(who).count(); }
+	int liberty(int i) const { return libs[root[i]]; }
+	int block(int i) const { return root[i]; }
+
+	/**
+	 * the base-4 code of the 8 neighbors of point i, where the k-th digit is the piece at neighbor k,
+	 * i.e., near(i, 0) ~ near(i, 3) are the digits 0 ~ 3, and corner(i, 0) ~ corner(i, 3) are the digits 4 ~ 7
+	 * the outside of the board is coded as hollow
+	 */
+	uint16_t pattern(int i) const { return code[i]; }
+
+	/**
+	 * the Zobrist key of the stones and the player to move
+	 */
+	uint64_t hash() const { return key[0] ^ (who_take_turns() == board::white ? zobrist_turn() : 0); }
+	/**
+	 * the key after who places a stone at i, without placing it
+	 */
+	uint64_t hash_after(int i, unsigned who) const {
+		return key[0] ^ zobrist(i, who) ^ (who == board::black ? zobrist_turn() : 0);
+	}
+
+	/**
+	 * the smallest key among the 8 symmetric images, the same for all symmetric positions
+	 */
+	uint64_t canonical_hash() const {
+		return key[canonical_symmetry()] ^ (who_take_turns() == board::white ? zobrist_turn() : 0);
+	}
+	/**
+	 * the symmetry t whose image has the canonical key, so symmetric(i, t) is point i in the canonical image
+	 */
+	int canonical_symmetry() const {
+		return std::min_element(key, key + symmetries) - key;
+	}
+	/**
+	 * the canonical key after who places a stone at i, without placing it
+	 */
+	uint64_t canonical_hash_after(int i, unsigned who) const {
+		uint64_t k = key[0] ^ zobrist(i, who);
+		for (int t = 1; t < symmetries; t++) k = std::min(k, key[t] ^ zobrist(symmetric(i, t), who));
+		return k ^ (who == board::black ? zobrist_turn() : 0);
+	}
+
+	/**
+	 * whether the stones are unchanged under the t-th symmetry
+	 */
+	bool symmetric_under(int t) const {
+		if (key[t] != key[0]) return false;
+		for (int i = 0; i < cells; i++) if (cell[symmetric(i, t)] != cell[i]) return false;
+		return true;
+	}
+	/**
+	 * the legal moves of who, keeping only the smallest point of each group of moves
+	 * that are symmetric to each other under the symmetries of this position
+	 */
+	mask unique_legal_of(unsigned who) const {
+		int group[symmetries], size = 0;
+		for (int t = 1; t < symmetries; t++) if (symmetric_under(t)) group[size++] = t;
+		mask unique = legal_of(who);
+		if (size == 0) return unique;
+		for (size_t i = unique._Find_first(); i < cells; i = unique._Find_next(i)) {
+			for (int k = 0; k < size; k++) {
+				int j = symmetric(i, group[k]);
+				if (j > int(i)) unique.reset(j);
+			}
+		}
+		return unique;
+	}
+
+	static uint64_t zobrist(int i, unsigned who) { return zobrist_table()[i][who - 1]; }
+	static uint64_t zobrist_turn() { return zobrist_table()[edge][0]; }
+
+	/**
+	 * the image of point i under the t-th symmetry, i.e., transpose if t >= 4, then rotate clockwise by t % 4 times
+	 */
+	static int symmetric(int i, int t) { return symmetry_table()[t][i]; }
+	/**
+	 * the point whose image under the t-th symmetry is i
+	 */
+	static int inverse_symmetric(int i, int t) { return symmetry_table()[symmetries + t][i]; }
+
+	/**
+	 * the i-th neighbor of point p, in the order of (x, y - 1), (x - 1, y), (x + 1, y), (x, y + 1)
+	 * the outside of the board is the point position::edge, which is always hollow
+	 */
+	static int near(int p, int k) { return neighbors()[p][k]; }
+	/**
+	 * the i-th diagonal neighbor of point p, in the order of (x - 1, y - 1), (x + 1, y - 1), (x - 1, y + 1), (x + 1, y + 1)
+	 */
+	static int corner(int p, int k) { return neighbors()[p][4 + k]; }
+
+	/**
+	 * place a stone of who at i, the move should be legal
+	 * the turn passes to the opponent of who, as board::undo does
+	 */
+	void place(int i, unsigned who) {
+		unsigned opp = 3u - who;
+		board::point p(i);
+		b[p.x][p.y] = who;
+		b.info({static_cast<board::piece_type>(opp)});
+		cell[i] = who;
+		root[i] = next[i] = i;
+		for (int t = 0; t < symmetries; t++) key[t] ^= zobrist(symmetric(i, t), who);
+		for (int k = 0; k < 8; k++) {
+			// i is the opposite neighbor of its k-th neighbor, i.e., 0 <-> 3, 1 <-> 2, 4 <-> 7, 5 <-> 6
+			code[neighbors()[i][k]] += who << (2 * (k < 4 ? 3 - k : 11 - k));
+		}
+
+		int opp_blocks[4], num_opp = 0;
+		for (int k = 0; k < 4; k++) {
+			int n = near(i, k);
+			if (cell[n] == who && root[n] != root[i]) {
+				// merge the block of n into the block of i
+				int r = root[n], s = r;
+				do { root[s] = i; s = next[s]; } while (s != r);
+				std::swap(next[i], next[r]);
+			} else if (cell[n] == opp && !contains(opp_blocks, num_opp, root[n])) {
+				opp_blocks[num_opp++] = root[n];
+				libs[root[n]]--;
+			}
+		}
+		libs[i] = count_liberty_of(i);
+
+		// the legality only changes at i, its neighbors, and the liberties of the blocks touched
+		for (int k = 0; k < 4; k++) update_legal(near(i, k));
+		update_legal(i);
+		update_liberties_of(i);
+		for (int j = 0; j < num_opp; j++) update_liberties_of(opp_blocks[j]);
+	}
+	void place(int i) {
+		place(i, who_take_turns());
+	}
+
+private:
+	static bool contains(const int* v, int n, int x) {
+		for (int j = 0; j < n; j++) if (v[j] == x) return true;
+		return false;
+	}
+
+	int count_liberty_of(int r) const {
+		uint8_t seen[cells + 1] = {};
+		int count = 0, s = r;
+		do {
+			for (int k = 0; k < 4; k++) {
+				int n = near(s, k);
+				if (cell[n] == board::empty && !seen[n]) seen[n] = 1, count++;
+			}
+			s = next[s];
+		} while (s != r);
+		return count;
+	}
+
+	void update_liberties_of(int r) {
+		int s = r;
+		do {
+			for (int k = 0; k < 4; k++) {
+				int n = near(s, k);
+				if (cell[n] == board::empty) update_legal(n);
+			}
+			s = next[s];
+		} while (s != r);
+	}
+
+	/**
+	 * the same rule as board::test, decided by the liberties of the nearby blocks
+	 */
+	bool test_legal(int i, unsigned who) const {
+		if (cell[i] != board::empty) return false;
+		bool alive = false;
+		for (int k = 0; k < 4; k++) {
+			int n = near(i, k);
+			unsigned c = cell[n];
+			if (c == board::empty) alive = true;
+			else if (c == who) alive |= libs[root[n]] > 1;        // not a suicide
+			else if (c == 3u - who && libs[root[n]] == 1) return false; // take the last liberty
+		}
+		return alive;
+	}
+
+	void update_legal(int i) {
+		if (i == edge) return;
+		legal_move[0][i] = test_legal(i, board::black);
+		legal_move[1][i] = test_legal(i, board::white);
+	}
+
+	typedef std::array<std::array<int, 8>, cells> adjacency;
+	static const adjacency& neighbors() { static adjacency near; return near; }
+	static __attribute__((constructor)) void init_neighbors() {
+		adjacency& near = const_cast<adjacency&>(neighbors());
+		for (int i = 0; i < cells; i++) {
+			board::point p(i);
+			near[i][0] = p.y > 0 ? i - 1 : int(edge);
+			near[i][1] = p.x > 0 ? i - board::size_y : int(edge);
+			near[i][2] = p.x < board::size_x - 1 ? i + board::size_y : int(edge);
+			near[i][3] = p.y < board::size_y - 1 ? i + 1 : int(edge);
+			bool l = p.x > 0, r = p.x < board::size_x - 1, d = p.y > 0, u = p.y < board::size_y - 1;
+			near[i][4] = l && d ? i - board::size_y - 1 : int(edge);
+			near[i][5] = r && d ? i + board::size_y - 1 : int(edge);
+			near[i][6] = l && u ? i - board::size_y + 1 : int(edge);
+			near[i][7] = r && u ? i + board::size_y + 1 : int(edge);
+		}
+	}
+
+	typedef std::array<std::array<int, cells>, 2 * symmetries> symmetry_map; // the maps, then their inverses
+	static const symmetry_map& symmetry_table() { static symmetry_map sym; return sym; }
+	static __attribute__((constructor)) void init_symmetry() {
+		symmetry_map& sym = const_cast<symmetry_map&>(symmetry_table());
+		for (int t = 0; t < symmetries; t++) {
+			for (int i = 0; i < cells; i++) {
+				// follow a single stone through the same transformations as the board
+				board b;
+				board::point p(i);
+				b[p.x][p.y] = board::black;
+				if (t >= 4) b.transpose();
+				b.rotate(t % 4);
+				for (int j = 0; j < cells; j++) {
+					board::point q(j);
+					if (b[q.x][q.y] == board::black) sym[t][i] = j;
+				}
+				sym[symmetries + t][sym[t][i]] = i;
+			}
+		}
+	}
+
+	typedef std::array<std::array<uint64_t, 2>, cells + 1> zobrist_keys;
+	static const zobrist_keys& zobrist_table() { static zobrist_keys z; return z; }
+	static __attribute__((constructor)) void init_zobrist() {
+		zobrist_keys& z = const_cast<zobrist_keys&>(zobrist_table());
+		std::mt19937_64 engine(20221212); // fixed, so that the keys are the same in every run
+		for (auto& keys : z) for (auto& k : keys) k = engine();
+	}
+
+private:
+	board b;
+	uint8_t cell[cells + 1];
+	uint8_t root[cells + 1];
+	uint8_t next[cells + 1];
+	uint8_t libs[cells + 1];
+	uint16_t code[cells + 1];
+	uint64_t key[symmetries]; // the key of the t-th symmetric image
+	mask legal_move[2];
+};
@@ -0,0 +1,317 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * referee.cpp: Concurrent GTP referee of two engine binaries, in place of gogui-twogtp
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <csignal>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include "board.h"
+#include "action.h"
+#include "agent.h"
+#include "episode.h"
+
+/**
+ * an engine process, e.g., "./nogo --shell --black='N=12000' --white='N=12000'", which talks GTP over pipes
+ * the engine is an agent, so the games are played by episode as the local games,
+ * take_action asks genmove, and an illegal reply, a resignation, or a broken pipe is a pass, i.e., a loss
+ *
+ * an engine which does not reply within its time (or within patience seconds, except for genmove without a time limit)
+ * is killed, and started again for the next game
+ */
+class gtp_engine : public agent {
+public:
+	gtp_engine(const std::string& command, const std::string& args) : agent(args), command(command), pid(-1), in(-1), out(-1) {}
+	virtual ~gtp_engine() {
+		if (pid > 0) ask("quit", 1);
+		stop();
+	}
+
+	/**
+	 * send a command and return the reply without "= ", or "?" + the error message,
+	 * or "?" if the pipe is broken or there is no reply within timeout seconds (0 for no limit)
+	 * the lines before the reply (e.g., the banner of nogo) are skipped
+	 */
+	std::string ask(const std::string& cmd, double timeout = 0) {
+		if (pid < 0) start();
+		std::string line = cmd + "\n";
+		if (write(out, line.data(), line.size()) != ssize_t(line.size())) return "?";
+		auto deadline = std::chrono::steady_clock::now()
+			+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeout));
+		std::string reply;
+		bool started = false;
+		for (std::string text; next_line(text, timeout > 0 ? &deadline : nullptr); ) {
+			if (!started) {
+				if (text.empty() || (text[0] != '=' && text[0] != '?')) continue;
+				started = true;
+				reply = text[0] == '?' ? "?" : "";
+				text.erase(0, text.find_first_not_of("=? 0123456789"));
+			} else if (text.empty()) {
+				return reply;
+			} else {
+				reply += "\n";
+			}
+			reply += text;
+		}
+		stop(); // no reply, the engine is broken
+		return "?";
+	}
+
+	virtual void open_episode(const std::string& flag = "") {
+		ask("clear_board", patience);
+		thinking = 0;
+	}
+
+	virtual action take_action(const board& state, int steps) {
+		unsigned who = state.info().who_take_turns;
+		auto start = std::chrono::steady_clock::now();
+		std::string reply = ask(std::string("genmove ") + (who == board::black ? "b" : "w"), limit ? limit - thinking + 1 : 0);
+		thinking += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		board::point p(reply);
+		if (reply.empty() || reply[0] == '?' || p.i < 0) return action(); // resign, error, or a broken pipe
+		return action::place(p, who);
+	}
+
+	/**
+	 * tell the engine the move of the opponent
+	 */
+	bool play(const action::place& move) {
+		std::string color = move.color() == board::black ? "b" : "w";
+		return ask("play " + color + " " + std::string(move.position()), patience) != "?";
+	}
+
+	double seconds() const { return thinking; }
+
+private:
+	void start() {
+		int to[2], from[2];
+		if (pipe(to) != 0 || pipe(from) != 0) throw std::runtime_error("cannot create pipes for " + command);
+		pid = fork();
+		if (pid < 0) throw std::runtime_error("cannot fork " + command);
+		if (pid == 0) { // the engine
+			dup2(to[0], STDIN_FILENO);
+			dup2(from[1], STDOUT_FILENO);
+			if (property("quiet") == "1") freopen("/dev/null", "w", stderr);
+			close(to[0]), close(to[1]), close(from[0]), close(from[1]);
+			execl("/bin/sh", "sh", "-c", command.c_str(), (char*) nullptr);
+			_exit(127);
+		}
+		close(to[0]), close(from[1]);
+		out = to[1];
+		in = from[0];
+		buffer.clear();
+	}
+
+	void stop() {
+		if (pid < 0) return;
+		close(out), close(in);
+		kill(pid, SIGKILL);
+		waitpid(pid, nullptr, 0);
+		pid = -1;
+	}
+
+	/**
+	 * the next line from the engine, false at the end of the pipe or after the deadline
+	 */
+	bool next_line(std::string& line, const std::chrono::steady_clock::time_point* deadline) {
+		while (buffer.find('\n') == std::string::npos) {
+			int wait = -1;
+			if (deadline) {
+				auto left = std::chrono::duration_cast<std::chrono::milliseconds>(*deadline - std::chrono::steady_clock::now());
+				if (left.count() <= 0) return false;
+				wait = left.count();
+			}
+			struct pollfd fd = { in, POLLIN, 0 };
+			if (poll(&fd, 1, wait) <= 0) return false;
+			char data[4096];
+			ssize_t n = read(in, data, sizeof(data));
+			if (n <= 0) return false;
+			buffer.append(data, n);
+		}
+		size_t end = buffer.find('\n');
+		line = buffer.substr(0, end);
+		buffer.erase(0, end + 1);
+		if (line.size() && line.back() == '\r') line.pop_back();
+		return true;
+	}
+
+	std::string command;
+	pid_t pid;
+	int in, out;
+	std::string buffer;
+	double thinking = 0;
+	double limit = option("time", 0.0); // the thinking time of a game in seconds, 0 for no limit
+	double patience = option("patience", 10.0); // the seconds to wait for the other replies
+};
+
+/**
+ * the result of a game, for the summary
+ */
+struct game_result {
+	std::unique_ptr<episode> game;
+	bool first_black;
+	std::string fault; // "illegal", "timeout", or "resign" of the loser, empty if the loser has no legal move
+};
+
+int main(int argc, const char* argv[]) {
+	std::cout << "HollowNoGo-Referee: ";
+	std::copy(argv, argv + argc, std::ostream_iterator<const char*>(std::cout, " "));
+	std::cout << std::endl << std::endl;
+
+	std::string command[2][2]; // the commands of [player][black, white]
+	std::string save_path;
+	size_t total = 10, tables = 1;
+	double time_limit = 0;
+	bool quiet = false;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		auto match_arg = [&](std::string flag) -> bool {
+			auto it = arg.find_first_not_of('-');
+			return arg.find(flag, it) == it;
+		};
+		auto next_opt = [&]() -> std::string {
+			auto it = arg.find('=') + 1;
+			return it ? arg.substr(it) : argv[++i];
+		};
+		if (match_arg("p1b")) {
+			command[0][0] = next_opt();
+		} else if (match_arg("p1w")) {
+			command[0][1] = next_opt();
+		} else if (match_arg("p2b")) {
+			command[1][0] = next_opt();
+		} else if (match_arg("p2w")) {
+			command[1][1] = next_opt();
+		} else if (match_arg("p1")) {
+			command[0][0] = command[0][1] = next_opt();
+		} else if (match_arg("p2")) {
+			command[1][0] = command[1][1] = next_opt();
+		} else if (match_arg("total")) {
+			total = std::stoull(next_opt());
+		} else if (match_arg("games")) {
+			tables = std::stoull(next_opt());
+		} else if (match_arg("time")) {
+			time_limit = std::stod(next_opt());
+		} else if (match_arg("quiet")) {
+			quiet = true;
+		} else if (match_arg("save")) {
+			save_path = next_opt();
+		}
+	}
+	for (int p = 0; p < 2; p++) {
+		for (int c = 0; c < 2; c++) {
+			if (command[p][c].empty()) {
+				std::cerr << "missing the command of P" << (p + 1) << (c ? "W" : "B") << std::endl;
+				return 1;
+			}
+		}
+	}
+	signal(SIGPIPE, SIG_IGN); // a crashed engine loses the game instead of killing the referee
+	tables = std::max<size_t>(1, std::min(tables, total));
+
+	std::mutex mutex;
+	std::condition_variable done;
+	std::vector<game_result> results(total);
+	size_t next = 0;
+
+	// each table keeps its own engine processes, one per distinct command of each player, for all its games
+	// game g is played by P1 as black if g is even
+	auto table = [&]() {
+		std::map<std::string, std::unique_ptr<gtp_engine>> engines;
+		auto engine_of = [&](int p, int c) -> gtp_engine& {
+			std::unique_ptr<gtp_engine>& e = engines[std::to_string(p) + command[p][c]];
+			if (!e) e.reset(new gtp_engine(command[p][c], "name=P" + std::to_string(p + 1) + " role=any quiet=" + (quiet ? "1" : "0") + " time=" + std::to_string(time_limit)));
+			return *e;
+		};
+		while (true) {
+			size_t g;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (next == total) break;
+				g = next++;
+			}
+			bool first_black = g % 2 == 0;
+			gtp_engine& black = engine_of(first_black ? 0 : 1, 0);
+			gtp_engine& white = engine_of(first_black ? 1 : 0, 1);
+			std::string names[] = { first_black ? "P1" : "P2", first_black ? "P2" : "P1" };
+			black.open_episode();
+			if (&white != &black) white.open_episode();
+
+			std::unique_ptr<episode> game(new episode());
+			game->open_episode(names[0] + ":" + names[1]);
+			std::string fault;
+			while (true) {
+				agent& who = game->take_turns(black, white);
+				gtp_engine& mover = static_cast<gtp_engine&>(who);
+				gtp_engine& other = &who == &black ? white : black;
+				action move = mover.take_action(game->state(), 0);
+				if (time_limit > 0 && mover.seconds() > time_limit) {
+					fault = "timeout";
+					break;
+				}
+				if (game->apply_action(move) != true) {
+					position pos(game->state());
+					if (move.type() == action::place::type) fault = "illegal";
+					else if (pos.count_legal(pos.who_take_turns()) != 0) fault = "resign"; // fine, but not the end of the game
+					break;
+				}
+				if (&other != &mover && !other.play(move)) {
+					fault = "illegal"; // the opponent rejects a legal move, so it is out of sync
+					break;
+				}
+			}
+			// the player to move loses, i.e., the one who cannot move, or the one at fault
+			bool black_to_move = game->state().info().who_take_turns == board::black;
+			game->close_episode(black_to_move ? names[1] : names[0]);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			results[g] = { std::move(game), first_black, fault };
+			done.notify_one();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < tables; t++) threads.emplace_back(table);
+
+	std::ofstream out;
+	if (save_path.size()) out.open(save_path, std::ios::out | std::ios::trunc);
+	size_t p1_wins = 0, faults = 0;
+	for (size_t g = 0; g < total; g++) {
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&]() { return results[g].game != nullptr; });
+		game_result res = std::move(results[g]);
+		lock.unlock();
+
+		bool black_won = res.game->state().info().who_take_turns == board::white;
+		bool p1_won = black_won == res.first_black;
+		p1_wins += p1_won;
+		faults += res.fault.size() > 0;
+		if (out.is_open()) out << *res.game << std::endl;
+		std::cout << "game " << g << ": " << (res.first_black ? "P1B vs P2W" : "P2B vs P1W") << ", "
+		          << (p1_won ? "P1" : "P2") << " wins in " << res.game->step() << " moves"
+		          << (res.fault.size() ? " by " + res.fault : "") << std::endl;
+	}
+	for (auto& t : threads) t.join();
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "P1: " << p1_wins << "/" << total << " = " << (p1_wins * 100.0 / total) << "%" << std::endl;
+	std::cout << "P2: " << (total - p1_wins) << "/" << total << " = " << ((total - p1_wins) * 100.0 / total) << "%" << std::endl;
+	if (faults) std::cout << faults << " games ended by an illegal move, a timeout, or a resignation" << std::endl;
+	return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * sprt.h: Sequential probability ratio test of the Elo difference between two agents
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+/**
+ * the test of H0: elo = elo0 against H1: elo = elo1, where a game is won with p = 1 / (1 + 10^(-elo / 400)),
+ * the log-likelihood ratio of the results is compared with the bounds of Wald,
+ * i.e., H0 is accepted below log(beta / (1 - alpha)), and H1 above log((1 - beta) / alpha)
+ *
+ * NoGo has no draws, so each game is a Bernoulli trial
+ */
+class sprt {
+public:
+	enum result { undecided = 0, accept_h0 = -1, accept_h1 = 1 };
+
+	sprt(double elo0 = 0, double elo1 = 10, double alpha = 0.05, double beta = 0.05)
+		: p0(probability(elo0)), p1(probability(elo1)),
+		  lower(std::log(beta / (1 - alpha))), upper(std::log((1 - beta) / alpha)), wins(0), losses(0) {}
+
+	void add(bool win) { win ? wins++ : losses++; }
+
+	double llr() const {
+		return wins * std::log(p1 / p0) + losses * std::log((1 - p1) / (1 - p0));
+	}
+	result decision() const {
+		double v = llr();
+		return v >= upper ? accept_h1 : v <= lower ? accept_h0 : undecided;
+	}
+	double lower_bound() const { return lower; }
+	double upper_bound() const { return upper; }
+
+	size_t games() const { return wins + losses; }
+	size_t won() const { return wins; }
+	size_t lost() const { return losses; }
+
+	/**
+	 * the Elo difference of the score so far, and the half width of its 95% interval
+	 */
+	double elo() const { return elo_of(score()); }
+	double elo_error() const {
+		size_t n = games();
+		if (n == 0) return 0;
+		double s = score(), e = 1.96 * std::sqrt(s * (1 - s) / n);
+		return (elo_of(s + e) - elo_of(s - e)) / 2;
+	}
+	double score() const { return games() ? double(wins) / games() : 0.5; }
+
+	static double probability(double elo) { return 1 / (1 + std::pow(10, -elo / 400)); }
+	static double elo_of(double score) {
+		score = std::min(std::max(score, 1e-3), 1 - 1e-3);
+		return -400 * std::log10(1 / score - 1);
+	}
+
+private:
+	double p0, p1;
+	double lower, upper;
+	size_t wins, losses;
+};
@@ -12,6 +12,7 @@
 #include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <cmath>
 #include "board.h"
 #include "action.h"
 #include "episode.h"
@@ -82,10 +83,34 @@ public:
 		show(data.size());
 	}
 
+	/**
+	 * show the win rate of black in last 'blk' games with its 95% confidence interval (Wilson score)
+	 *
+	 * the format is
+	 * 1000   black win = 53.5% [50.4%, 56.6%] in 1000 games
+	 */
+	void show_interval(size_t blk = 0) const {
+		size_t num = std::min(data.size(), blk ?: block);
+		if (num == 0) return;
+		size_t BW = 0;
+		for (auto it = data.end() - num; it != data.end(); it++) BW += it->step() % 2 == 1;
+		double n = num, p = num ? BW / n : 0, z = 1.96;
+		double center = (p + z * z / (2 * n)) / (1 + z * z / n);
+		double half = z * std::sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / (1 + z * z / n);
+		std::cout << count << "\t";
+		std::cout << "black win = " << (p * 100) << "% [" << (std::max(center - half, 0.0) * 100)
+		          << "%, " << (std::min(center + half, 1.0) * 100) << "%] in " << num << " games";
+		std::cout << std::endl;
+	}
+
 	bool is_finished() const {
 		return count >= total;
 	}
 
+	size_t remaining() const {
+		return total > count ? total - count : 0;
+	}
+
 	bool is_episode_ongoing() const {
 		return data.size() && data.back().time() < 0;
 	}
@@ -101,6 +126,15 @@ public:
 		if (count % block == 0) show();
 	}
 
+	/**
+	 * add an episode which is already closed, e.g., a game played by another thread
+	 */
+	void append_episode(const episode& ep) {
+		if (count++ >= limit) data.pop_front();
+		data.push_back(ep);
+		if (count % block == 0) show();
+	}
+
 	episode& at(size_t i) {
 		return data.at(i);
 	}
@@ -0,0 +1,131 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * stopping.h: Adaptive stopping rule over the merged root statistics of all search threads
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <cmath>
+#include <cstdint>
+#include "board.h"
+
+/**
+ * every thread records the root move and the result of each simulation, and tests the rules every few simulations,
+ * the search of all threads stops as soon as one of the enabled rules holds
+ *
+ * visit:  the most visited move cannot be overtaken, i.e., second + visit * remaining < best
+ *         (visit = 1 is exact for the most-visited choice, smaller values are more aggressive)
+ * ci:     the lower confidence bound of the most visited move is above the upper bound of every other move
+ *         with at least ci_min visits, with the normal approximation at ci standard deviations
+ * stable: the most visited move has not changed during the last stable fraction of the budget
+ *
+ * no rule is tested before the min fraction of the budget is spent
+ */
+class stopping_rule {
+public:
+	struct options {
+		float visit = 0.5f;   // the factor of the visit-count bound, 0 to disable
+		float ci = 0.0f;      // the z value of the confidence interval test, 0 to disable
+		int ci_min = 64;      // the visits of a move to take part in the confidence interval test
+		float stable = 0.0f;  // the fraction of the budget for the stable-best rule, 0 to disable
+		float min = 0.25f;    // the fraction of the budget before any rule is tested
+		int check = 64;       // the simulations of a thread between two tests
+	};
+
+	enum reason_type { none = 0, visit = 1, ci = 2, stable = 3, proven = 4 };
+
+	stopping_rule(const options& opt, uint64_t budget) : opt(opt), budget(budget), last_best(-1), best_since(0) {
+		for (auto& v : visits) v = 0;
+		for (auto& w : wins) w = 0;
+		done = 0;
+		stop = false;
+		why = none;
+		stop_at = 0;
+	}
+
+	/**
+	 * record a simulation through the root move, and test the rules once in a while
+	 * win: whether the simulation is a win for the player to move at the root
+	 */
+	void record(int move, bool win, uint64_t& local) {
+		visits[move].fetch_add(1, std::memory_order_relaxed);
+		if (win) wins[move].fetch_add(1, std::memory_order_relaxed);
+		done.fetch_add(1, std::memory_order_relaxed);
+		if (++local % opt.check == 0) test();
+	}
+
+	/**
+	 * stop all threads, e.g., once the root is proven, only the first reason is kept
+	 */
+	void finish(reason_type reason = proven) {
+		int expected = none;
+		if (why.compare_exchange_strong(expected, reason)) stop_at = simulations();
+		stop.store(true, std::memory_order_relaxed);
+	}
+	bool stopped() const { return stop.load(std::memory_order_relaxed); }
+	uint64_t simulations() const { return done.load(std::memory_order_relaxed); }
+
+	/**
+	 * the rule which stopped the search (none if the budget ran out), and the simulations of all threads by then
+	 */
+	reason_type reason() const { return reason_type(why.load()); }
+	static const char* name_of(reason_type reason) {
+		static const char* name[] = { "none", "visit", "ci", "stable", "proven" };
+		return name[reason];
+	}
+	uint64_t stopped_at() const { return stop_at; }
+
+private:
+	void test() {
+		std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+		if (!lock.owns_lock() || stopped()) return; // another thread is testing
+		uint64_t now = simulations();
+		if (now < opt.min * budget) return;
+
+		uint32_t n[cells], w[cells];
+		int best = -1, second = -1;
+		for (int i = 0; i < cells; i++) {
+			n[i] = visits[i].load(std::memory_order_relaxed);
+			w[i] = wins[i].load(std::memory_order_relaxed);
+			if (best == -1 || n[i] > n[best]) second = best, best = i;
+			else if (second == -1 || n[i] > n[second]) second = i;
+		}
+		if (best != last_best) last_best = best, best_since = now;
+		uint64_t remaining = budget > now ? budget - now : 0;
+
+		if (opt.visit > 0 && n[second] + opt.visit * remaining < n[best]) finish(visit);
+		if (opt.stable > 0 && now - best_since >= opt.stable * budget) finish(stable);
+		if (opt.ci > 0 && n[best] >= uint32_t(opt.ci_min)) {
+			bool separated = true;
+			float lower = bound(w[best], n[best], -opt.ci);
+			for (int i = 0; i < cells && separated; i++)
+				if (i != best && n[i] >= uint32_t(opt.ci_min) && bound(w[i], n[i], opt.ci) >= lower) separated = false;
+			if (separated) finish(ci);
+		}
+	}
+
+	static float bound(uint32_t w, uint32_t n, float z) {
+		float p = float(w) / n;
+		return p + z * std::sqrt(p * (1 - p) / n);
+	}
+
+private:
+	enum { cells = board::size_x * board::size_y };
+	const options opt;
+	const uint64_t budget;
+	std::array<std::atomic<uint32_t>, cells> visits;
+	std::array<std::atomic<uint32_t>, cells> wins;
+	std::atomic<uint64_t> done;
+	std::atomic<bool> stop;
+	std::atomic<int> why;
+	uint64_t stop_at;
+	std::mutex mutex;
+	int last_best;
+	uint64_t best_since;
+};
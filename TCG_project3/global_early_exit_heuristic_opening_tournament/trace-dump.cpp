@@ -0,0 +1,127 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * trace-dump.cpp: Reader of the search traces, as text or CSV
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "board.h"
+#include "stopping.h"
+#include "trace.h"
+
+std::string move_name(int i) {
+	return i >= 0 && i < board::size_x * board::size_y ? std::string(board::point(i)) : "PASS";
+}
+
+std::string pv_of(const search_trace::record& r) {
+	std::string pv;
+	for (uint8_t m : r.moves) pv += (pv.size() ? " " : "") + move_name(m);
+	return pv;
+}
+
+double average_depth(const search_trace::record& r) {
+	uint64_t n = 0, sum = 0;
+	for (size_t d = 0; d < r.depth.size(); d++) n += r.depth[d], sum += d * r.depth[d];
+	return n ? double(sum) / n : 0;
+}
+
+const char* source_name(int source) {
+	static const char* name[] = { "mcts", "halving", "dfpn" };
+	return source >= 0 && source < 3 ? name[source] : "unknown";
+}
+
+/**
+ * a record as a few lines of text, the children are listed by visits
+ */
+void dump_text(const search_trace::record& r, size_t top) {
+	double phases = std::max<double>(r.phase[0] + r.phase[1] + r.phase[2] + r.phase[3], 1e-9);
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "game " << r.game << " step " << r.step << " " << "?BW"[r.who % 3] << " " << move_name(r.move)
+	          << ": " << source_name(r.source) << " " << r.simulations << "/" << r.budget << " sims in " << r.msec << " ms, "
+	          << int(r.threads) << " threads, " << r.nodes << " nodes, " << r.bytes / 1048576.0 << " MB, "
+	          << "stop " << stopping_rule::name_of(stopping_rule::reason_type(r.stop)) << std::endl;
+	std::cout << "  phases: select " << 100 * r.phase[0] / phases << "% expand " << 100 * r.phase[1] / phases
+	          << "% simulate " << 100 * r.phase[2] / phases << "% backprop " << 100 * r.phase[3] / phases << "%" << std::endl;
+	std::cout << "  pv: " << pv_of(r) << std::endl;
+	std::cout << "  depth: avg " << average_depth(r) << ",";
+	for (size_t d = 0; d < r.depth.size(); d++) std::cout << " " << r.depth[d];
+	std::cout << std::endl;
+
+	std::vector<search_trace::child> root = r.root;
+	std::sort(root.begin(), root.end(), [](const search_trace::child& a, const search_trace::child& b) { return a.visits > b.visits; });
+	if (top && root.size() > top) root.resize(top);
+	for (auto& c : root) {
+		std::cout << "  " << std::setw(4) << move_name(c.move) << std::setw(10) << c.visits
+		          << std::setw(8) << (c.visits ? 100.0 * c.wins / c.visits : 0) << "%"
+		          << (c.proven > 0 ? " win" : c.proven < 0 ? " loss" : "") << std::endl;
+	}
+}
+
+int main(int argc, const char* argv[]) {
+	std::string csv;
+	size_t top = 10;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		auto match_arg = [&](std::string flag) -> bool {
+			auto it = arg.find_first_not_of('-');
+			return arg.find(flag, it) == it;
+		};
+		auto next_opt = [&]() -> std::string {
+			auto it = arg.find('=') + 1;
+			return it ? arg.substr(it) : argv[++i];
+		};
+		if (arg[0] != '-') { // the trace files
+			paths.push_back(arg);
+		} else if (match_arg("csv")) { // --csv for one row per search, --csv=children for one row per root child
+			csv = arg.find('=') != std::string::npos ? next_opt() : "searches";
+		} else if (match_arg("top")) {
+			top = std::stoul(next_opt());
+		}
+	}
+
+	if (csv == "searches") {
+		std::cout << "file,game,step,color,move,source,stop,threads,msec,simulations,budget,nodes,bytes,"
+		             "select,expand,simulate,backprop,depth_avg,depth_max,pv" << std::endl;
+	} else if (csv == "children") {
+		std::cout << "file,game,step,color,move,visits,wins,proven" << std::endl;
+	} else if (csv.size()) {
+		std::cerr << "unknown csv mode: " << csv << std::endl;
+		return 1;
+	}
+
+	for (const std::string& path : paths) {
+		std::ifstream in(path, std::ios::in | std::ios::binary);
+		if (!search_trace::check(in)) {
+			std::cerr << "not a trace: " << path << std::endl;
+			return 1;
+		}
+		for (search_trace::record r; search_trace::read(in, r); ) {
+			char color = "?BW"[r.who % 3];
+			if (csv == "searches") {
+				std::cout << path << "," << r.game << "," << r.step << "," << color << "," << move_name(r.move) << ","
+				          << source_name(r.source) << "," << stopping_rule::name_of(stopping_rule::reason_type(r.stop)) << ","
+				          << int(r.threads) << "," << r.msec << "," << r.simulations << "," << r.budget << ","
+				          << r.nodes << "," << r.bytes << "," << r.phase[0] << "," << r.phase[1] << ","
+				          << r.phase[2] << "," << r.phase[3] << "," << average_depth(r) << ","
+				          << (r.depth.size() ? r.depth.size() - 1 : 0) << "," << pv_of(r) << std::endl;
+			} else if (csv == "children") {
+				for (auto& c : r.root) {
+					std::cout << path << "," << r.game << "," << r.step << "," << color << "," << move_name(c.move) << ","
+					          << c.visits << "," << c.wins << "," << int(c.proven) << std::endl;
+				}
+			} else {
+				dump_text(r, top);
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,173 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * trace.h: Compact binary trace of the searches, for offline analysis of the trees
+ *
+ * Author: Theory of Computer Games
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <stdexcept>
+
+/**
+ * one record per searched move: the root children merged over the threads, the principal variation,
+ * the histogram of the simulated depths, and the time of each phase
+ *
+ * the file is a header followed by the records, each record is a fixed part followed by the children,
+ * the moves of the principal variation, and the histogram buckets, see write and read
+ * the records are collected after the search and buffered in memory, so the simulations only count the depths
+ * the players writing to the same path share one trace (see shared), e.g., the tables of a tournament
+ */
+class search_trace {
+public:
+	struct header {
+		char magic[8];
+		uint32_t version;
+		uint32_t reserved;
+	};
+	struct child {
+		uint32_t visits;
+		uint32_t wins;  // the wins of the player to move at the root
+		uint8_t move;
+		int8_t proven;  // as node::proven, for the player to move at the root
+		uint16_t reserved;
+	};
+	struct fixed {
+		uint32_t game;         // the episode of the player, from 1
+		uint16_t step;         // the step of the game when the move is searched
+		uint8_t who;           // board::black or board::white
+		uint8_t stop;          // the stopping_rule::reason_type which stopped the search
+		uint8_t source;        // one of source_type
+		uint8_t children;      // the children follow the fixed part
+		uint8_t pv;            // then the moves of the principal variation
+		uint8_t depths;        // then the histogram buckets, where bucket d counts the simulations of depth d
+		uint8_t move;          // the move played, 255 for pass
+		uint8_t reserved;
+		uint16_t threads;
+		float msec;
+		uint32_t reserved2;    // zero, so the fixed part has no padding
+		uint64_t simulations;
+		uint64_t budget;
+		uint64_t nodes;        // the nodes expanded
+		uint64_t bytes;        // the tree memory after the search
+		float phase[4];        // the seconds of select, expand, simulate, and backpropagate, summed over the threads
+	};
+	static_assert(sizeof(fixed) == 72, "the fixed part of a record should have no padding");
+	struct record : fixed {
+		std::vector<child> root;
+		std::vector<uint8_t> moves;   // the principal variation
+		std::vector<uint32_t> depth;  // the histogram
+	};
+	enum source_type { from_mcts = 0, from_halving = 1, from_dfpn = 2 };
+	static constexpr const char* magic() { return "NOGOTRCE"; }
+
+	search_trace() {}
+	~search_trace() { close(); }
+	search_trace(const search_trace&) = delete;
+	search_trace& operator =(const search_trace&) = delete;
+
+	/**
+	 * the trace of a path, opened once and shared by all its writers
+	 */
+	static std::shared_ptr<search_trace> shared(const std::string& path) {
+		static std::mutex mutex;
+		static std::map<std::string, std::weak_ptr<search_trace>> traces;
+		std::lock_guard<std::mutex> lock(mutex);
+		std::shared_ptr<search_trace> trace = traces[path].lock();
+		if (!trace) {
+			trace = std::make_shared<search_trace>();
+			if (!trace->open(path)) throw std::invalid_argument("cannot open trace: " + path);
+			traces[path] = trace;
+		}
+		return trace;
+	}
+
+	/**
+	 * append the records to the file, so that a trace may collect many runs
+	 */
+	bool open(const std::string& path) {
+		close();
+		file.open(path, std::ios::out | std::ios::binary | std::ios::app);
+		if (!file.is_open()) return false;
+		if (file.tellp() == 0) {
+			header h = {};
+			std::memcpy(h.magic, magic(), 8);
+			h.version = 2; // version 1 had 8-bit threads and unset padding
+			file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		}
+		return bool(file);
+	}
+
+	void close() {
+		write_buffer();
+		if (file.is_open()) file.close();
+	}
+	bool is_open() const { return file.is_open(); }
+
+	void write(const record& r) {
+		std::lock_guard<std::mutex> lock(mutex);
+		fixed f = r;
+		f.children = r.root.size();
+		f.pv = r.moves.size();
+		f.depths = r.depth.size();
+		append(&f, sizeof(f));
+		append(r.root.data(), r.root.size() * sizeof(child));
+		append(r.moves.data(), r.moves.size());
+		append(r.depth.data(), r.depth.size() * sizeof(uint32_t));
+		if (buffer.size() >= (1 << 16)) write_buffer();
+	}
+
+	void flush() {
+		std::lock_guard<std::mutex> lock(mutex);
+		write_buffer();
+	}
+
+	/**
+	 * read the header of a trace file, false if it is not a trace
+	 */
+	static bool check(std::istream& in) {
+		header h;
+		if (!in.read(reinterpret_cast<char*>(&h), sizeof(h))) return false;
+		return std::strncmp(h.magic, magic(), 8) == 0 && h.version == 2;
+	}
+
+	/**
+	 * read the next record, false at the end of the file
+	 */
+	static bool read(std::istream& in, record& r) {
+		fixed& f = r;
+		if (!in.read(reinterpret_cast<char*>(&f), sizeof(f))) return false;
+		r.root.resize(f.children);
+		r.moves.resize(f.pv);
+		r.depth.resize(f.depths);
+		in.read(reinterpret_cast<char*>(r.root.data()), r.root.size() * sizeof(child));
+		in.read(reinterpret_cast<char*>(r.moves.data()), r.moves.size());
+		in.read(reinterpret_cast<char*>(r.depth.data()), r.depth.size() * sizeof(uint32_t));
+		if (!in) throw std::runtime_error("truncated trace record");
+		return true;
+	}
+
+private:
+	void write_buffer() {
+		if (!buffer.empty() && file.is_open()) file.write(buffer.data(), buffer.size()).flush();
+		buffer.clear();
+	}
+
+	void append(const void* data, size_t size) {
+		const char* p = static_cast<const char*>(data);
+		buffer.insert(buffer.end(), p, p + size);
+	}
+
+	std::ofstream file;
+	std::vector<char> buffer;
+	std::mutex mutex;
+};